@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "utils/types.h"
+
+namespace obj
+{
+    // The end of a particle's flight, due at `time` (seconds). `flight`
+    // tells which of the particle's flights it belongs to, and `lands`
+    // how that flight ends, as predicted: on the floor (1) or out at the
+    // sides (0).
+    struct TimedEvent
+    {
+        double time;
+        u32 index;
+        u16 flight;
+        u8 lands;
+    };
+
+    /**
+     * Min-heap of particle events ordered by time, then by index
+     *
+     * Events are never removed or updated in place: when a particle's
+     * prediction changes a new event is pushed and the old one is left
+     * behind. The owner recognises such stale events when they come due
+     * (for example because the particle's flight number has moved on) and
+     * calls prune() once stale events outnumber live ones.
+     *
+     * Ties go to the lower index, so the order events come due in does not
+     * depend on whether they were pushed one by one or heapified.
+     */
+    struct EventQueue
+    {
+        size_t size() const noexcept { return _heap.size(); }
+        bool empty() const noexcept { return _heap.empty(); }
+        void reserve(size_t count) { _heap.reserve(count); }
+        void clear() noexcept { _heap.clear(); }
+
+        void push(const TimedEvent &event)
+        {
+            _heap.push_back(event);
+            std::push_heap(_heap.begin(), _heap.end(), _later);
+        }
+
+        // Earliest event; the queue must not be empty
+        const TimedEvent &top() const noexcept { return _heap.front(); }
+
+        // True if the earliest event is due at `now`
+        bool due(double now) const noexcept
+        {
+            return !_heap.empty() && _heap.front().time <= now;
+        }
+
+        // Push events[0, count). A batch larger than the queue is appended
+        // and heapified in O(n) instead of pushed one by one.
+        void push(const TimedEvent *events, size_t count)
+        {
+            if (count < _heap.size())
+            {
+                for (size_t n = 0; n < count; ++n)
+                    push(events[n]);
+                return;
+            }
+            _heap.insert(_heap.end(), events, events + count);
+            std::make_heap(_heap.begin(), _heap.end(), _later);
+        }
+
+        void pop()
+        {
+            std::pop_heap(_heap.begin(), _heap.end(), _later);
+            _heap.pop_back();
+        }
+
+        // Drop every event for which `is_stale(event)` holds; O(n) heapify
+        // of the rest instead of n pushes
+        template <typename IsStale> void prune(IsStale &&is_stale)
+        {
+            _heap.erase(std::remove_if(_heap.begin(), _heap.end(), is_stale),
+                        _heap.end());
+            std::make_heap(_heap.begin(), _heap.end(), _later);
+        }
+
+    private:
+        static bool _later(const TimedEvent &a, const TimedEvent &b) noexcept
+        {
+            return a.time > b.time ||
+                   (a.time == b.time && a.index > b.index);
+        }
+
+        std::vector<TimedEvent> _heap;
+    };
+
+} // namespace obj
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "utils/globals.h"
+#include "utils/trig_table.h"
 
 // Instead of size_t (64-bit), use smaller types:
 
@@ -245,7 +246,7 @@ namespace obj
     // Hash function for Vec2 to use in unordered_set
     struct Vec2Hash
     {
-        constexpr u32 operator()(const Vec2 &v) const noexcept
+        u32 operator()(const Vec2 &v) const noexcept
         {
             // Convert floats to integers for hashing (with reasonable
             // precision)
@@ -1156,16 +1157,9 @@ namespace obj
         void _calculateRotationVariables(float pitch_val, float yaw_val,
                                          float roll_val)
         {
-            size_t pitch_index = angle_to_index(pitch_val);
-            size_t yaw_index = angle_to_index(yaw_val);
-            size_t roll_index = angle_to_index(roll_val);
-
-            pitch_sin = trig_table[pitch_index].first;
-            pitch_cos = trig_table[pitch_index].second;
-            yaw_sin = trig_table[yaw_index].first;
-            yaw_cos = trig_table[yaw_index].second;
-            roll_sin = trig_table[roll_index].first;
-            roll_cos = trig_table[roll_index].second;
+            trig_lookup(pitch_val, pitch_sin, pitch_cos);
+            trig_lookup(yaw_val, yaw_sin, yaw_cos);
+            trig_lookup(roll_val, roll_sin, roll_cos);
         }
 
         void _calculateRotationVariablesReverse(float pitch_val, float yaw_val,
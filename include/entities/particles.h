@@ -0,0 +1,434 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "entities/settled_archive.h"
+#include "utils/types.h"
+
+// ########## PACKED COLOR HELPERS ##########
+
+// Pack RGBA8 so the bytes in memory read r, g, b, a on little-endian targets
+inline constexpr u32 pack_rgba8(u8 r, u8 g, u8 b, u8 a = 255)
+{
+    return static_cast<u32>(r) | (static_cast<u32>(g) << 8) |
+           (static_cast<u32>(b) << 16) | (static_cast<u32>(a) << 24);
+}
+
+inline constexpr u8 unpack_r(u32 rgba) { return rgba & 0xFF; }
+inline constexpr u8 unpack_g(u32 rgba) { return (rgba >> 8) & 0xFF; }
+inline constexpr u8 unpack_b(u32 rgba) { return (rgba >> 16) & 0xFF; }
+inline constexpr u8 unpack_a(u32 rgba) { return (rgba >> 24) & 0xFF; }
+
+// ########## PACKED ANGLE HELPERS ##########
+
+// Angles stored as u16 fractions of a turn: 0.0001 rad resolution, and
+// wrapping is the integer overflow
+inline constexpr float ANGLE_U16_STEP = TWO_PI / 65536.0f;
+
+inline u16 pack_angle(float radians)
+{
+    // Nearest step; floor is a truncation corrected for negative values
+    const float t = radians * (1.0f / ANGLE_U16_STEP) + 0.5f;
+    const i64 truncated = static_cast<i64>(t);
+    return static_cast<u16>(truncated -
+                            (t < static_cast<float>(truncated) ? 1 : 0));
+}
+
+inline constexpr float unpack_angle(u16 angle)
+{
+    return static_cast<float>(angle) * ANGLE_U16_STEP;
+}
+
+namespace obj
+{
+    // Returned by ParticleStore::add when the pool is full
+    constexpr u32 NO_PARTICLE = 0xFFFFFFFFu;
+
+    // Membership lists a particle can belong to (exactly one at a time)
+    constexpr u8 LIST_NONE = 0;
+    constexpr u8 LIST_ACTIVE = 1;
+    constexpr u8 LIST_FADING = 3; // evicted, drawn until the fade ends
+
+    /**
+     * Structure-of-arrays storage for confetti particles
+     *
+     * Every confetti piece has the same size and shape, so nothing
+     * per-particle beyond its kinematic and visual state is stored. Each field
+     * lives in its own contiguous array and a particle is addressed by its
+     * index, so the physics loop streams through memory linearly instead of
+     * chasing pointers to heap-allocated Rectangle objects.
+     *
+     * Hot arrays are touched by the physics step every frame, cold arrays only
+     * on spawn, state changes and instance packing.
+     *
+     * Membership in the active / fading lists is index based: every particle
+     * remembers which list it is in and at which slot, so moving it between
+     * lists is a swap-and-pop instead of a linear search.
+     *
+     * Settled particles do not live here. settle() reduces a landed piece to
+     * a 20-byte record in the `settled` archive (with its own grid for the
+     * mouse) and frees its slot; wake() and fadeSettled() bring a record
+     * back into a slot. The pool therefore only has to hold what is in the
+     * air or fading, and a pile resting for hours costs a third of what it
+     * would as full slots.
+     *
+     * The store is a fixed-capacity pool: slots of released particles go on a
+     * free list and are handed out again by add(), and all arrays are
+     * reserved up front, so spawning never touches the heap. A slot is live
+     * exactly while it is in the active or fading list; renderers walk those
+     * lists and the archive rather than [0, size()).
+     *
+     * In analytic motion mode pos and vel of an airborne particle hold its
+     * launch state at launch_time rather than its current state (see
+     * systems/trajectory.h). The end of the flight is queued in the
+     * simulation, tagged with the slot's flight number, which every launch
+     * bumps and nothing resets, so an event outlived by its flight (or by
+     * the piece that held the slot) no longer matches.
+     *
+     * Only what the step and the renderer read is kept, quantized where the
+     * precision allows: the three rotation angles are u16 turn fractions
+     * (spawns draw them at 16 bits, so nothing is lost) and the color is
+     * packed RGBA8. Whatever the list already says is not stored again: a
+     * piece is moving exactly while it is on the active list, and a fading
+     * piece's fade starts at its spawn_time. Arbitrary shapes still use
+     * obj::Polygon.
+     *
+     * Per slot: 20 hot bytes + 20 cold bytes + 13 bytes of membership =
+     * 53 bytes, no allocations. The hot part is what the step streams;
+     * the rest is list bookkeeping and what only the renderer reads. Per
+     * settled piece: a 20-byte record plus 12 bytes in the grid.
+     */
+    struct ParticleStore
+    {
+        // ---------- hot ----------
+        std::vector<float> pos_x; // center position in world units
+        std::vector<float> pos_y;
+        std::vector<float> vel_x; // velocity in world units per second
+        std::vector<float> vel_y;
+        std::vector<float> k; // drag constant 0.5 * rho * Cd * A / mass
+
+        // ---------- cold ----------
+        std::vector<float> spawn_time;  // seconds, restarted when woken;
+                                        // the fade start once evicted
+        std::vector<float> launch_time; // analytic motion: time of pos/vel,
+                                        // set by launch_particle() and
+                                        // relative to launch_time_origin()
+        std::vector<u16> flight;        // analytic motion: launches so far
+        std::vector<u16> pitch;         // initial angles for GPU rotation,
+        std::vector<u16> yaw;           // see pack_angle()
+        std::vector<u16> roll;
+        std::vector<u32> color; // packed RGBA8
+
+        // ---------- membership ----------
+        std::vector<u32> active;    // airborne particles, updated every frame
+        std::vector<u32> fading;    // evicted, fading out before release
+        std::vector<u8> list_id;    // LIST_* the particle currently is in
+        std::vector<u32> list_slot; // position inside that list
+        SettledArchive settled;     // particles resting on the floor
+
+        // Released slots waiting to be reused by add()
+        std::vector<u32> free_slots;
+
+        // Shared by all confetti (same size and mass), set by the spawners:
+        // bounding circle radius, drag constant and rotation speed in rad/s
+        float radius = 0.0f;
+        float drag = 0.0f;
+        float spin = 0.0f;
+
+        ParticleStore() = default;
+        explicit ParticleStore(size_t max_particles)
+        {
+            set_capacity(max_particles);
+        }
+
+        // Slots handed out so far, live or free
+        size_t size() const noexcept { return pos_x.size(); }
+        bool empty() const noexcept { return live() == 0; }
+
+        // Particles currently drawn (active, settled or fading)
+        size_t live() const noexcept
+        {
+            return active.size() + settled.size() + fading.size();
+        }
+
+        // Pool limit, 0 = grow without limit
+        size_t capacity() const noexcept { return _capacity; }
+        bool full() const noexcept
+        {
+            return free_slots.empty() && _capacity != 0 && size() >= _capacity;
+        }
+
+        // Fix the pool size and allocate every array for it up front
+        void set_capacity(size_t max_particles)
+        {
+            _capacity = max_particles;
+            reserve(max_particles);
+        }
+
+        void reserve(size_t capacity)
+        {
+            pos_x.reserve(capacity);
+            pos_y.reserve(capacity);
+            vel_x.reserve(capacity);
+            vel_y.reserve(capacity);
+            k.reserve(capacity);
+            spawn_time.reserve(capacity);
+            launch_time.reserve(capacity);
+            flight.reserve(capacity);
+            pitch.reserve(capacity);
+            yaw.reserve(capacity);
+            roll.reserve(capacity);
+            color.reserve(capacity);
+            list_id.reserve(capacity);
+            list_slot.reserve(capacity);
+            active.reserve(capacity);
+            settled.reserve(capacity);
+            fading.reserve(capacity);
+            free_slots.reserve(capacity);
+        }
+
+        void clear() noexcept
+        {
+            pos_x.clear();
+            pos_y.clear();
+            vel_x.clear();
+            vel_y.clear();
+            k.clear();
+            spawn_time.clear();
+            launch_time.clear();
+            flight.clear();
+            pitch.clear();
+            yaw.clear();
+            roll.clear();
+            color.clear();
+            active.clear();
+            settled.clear();
+            fading.clear();
+            list_id.clear();
+            list_slot.clear();
+            free_slots.clear();
+        }
+
+        // (Re)build the settled grid over a world of the given size
+        void configure_grid(float width, float height, float cell_size)
+        {
+            settled.configureGrid(width, height, cell_size);
+        }
+
+        // Put a moving particle on the active list, reusing a free slot when
+        // there is one; returns its index, or NO_PARTICLE if the pool is full
+        u32 add(float x, float y, float vx, float vy, float drag_k,
+                float spawn, float p, float yw, float r, u32 rgba)
+        {
+            const u32 index = _takeSlot();
+            if (index == NO_PARTICLE)
+                return NO_PARTICLE;
+
+            pos_x[index] = x;
+            pos_y[index] = y;
+            vel_x[index] = vx;
+            vel_y[index] = vy;
+            k[index] = drag_k;
+            spawn_time[index] = spawn;
+            pitch[index] = pack_angle(p);
+            yaw[index] = pack_angle(yw);
+            roll[index] = pack_angle(r);
+            color[index] = rgba;
+            list_id[index] = LIST_NONE;
+            _link(index, LIST_ACTIVE);
+            return index;
+        }
+
+        // Put up to `count` new moving particles on the active list at once
+        // and write their indices to `out`: free slots are reused first,
+        // then every array grows a single time. Only list membership is
+        // set; the caller fills in the rest. Returns how many were added
+        // (fewer if the pool runs out).
+        size_t addBulk(size_t count, u32 *out)
+        {
+            size_t n = 0;
+            while (n < count && !free_slots.empty())
+            {
+                out[n++] = free_slots.back();
+                free_slots.pop_back();
+            }
+
+            for (size_t m = 0; m < n; ++m)
+            {
+                const u32 index = out[m];
+                list_id[index] = LIST_NONE;
+                _link(index, LIST_ACTIVE);
+            }
+
+            size_t grow = count - n;
+            if (_capacity != 0)
+                grow = std::min(grow, _capacity - std::min(_capacity, size()));
+            const u32 first = static_cast<u32>(size());
+            _grow(grow);
+
+            // Grown slots are contiguous and already zeroed: plain fills
+            // and one pass for the list links
+            std::fill_n(list_id.begin() + first, grow, LIST_ACTIVE);
+            const u32 slot = static_cast<u32>(active.size());
+            active.resize(slot + grow);
+            u32 *grown = out + n;
+            for (u32 g = 0; g < grow; ++g)
+            {
+                grown[g] = first + g;
+                list_slot[first + g] = slot + g;
+                active[slot + g] = first + g;
+            }
+            return n + grow;
+        }
+
+        // ---------- O(1) state transitions ----------
+
+        // Landed on the floor at `time`: archive the piece at its current
+        // position with the orientation it shows then, and free its slot.
+        // Returns the record id.
+        u32 settle(u32 index, float time)
+        {
+            const u16 turned =
+                pack_angle(spin * (time - spawn_time[index]));
+            const u32 id = settled.add(
+                pos_x[index], pos_y[index],
+                static_cast<u16>(pitch[index] + turned),
+                static_cast<u16>(yaw[index] + turned),
+                static_cast<u16>(roll[index] + turned), color[index],
+                spawn_time[index]);
+            release(index);
+            return id;
+        }
+
+        // Woken by the mouse: bring settled record `id` back into a slot on
+        // the active list, at rest and with its flight (and spin) starting
+        // at `time`. Returns the index, or NO_PARTICLE (and the record
+        // stays archived) if the pool is full.
+        u32 wake(u32 id, float time)
+        {
+            const u32 index = _restore(id, time);
+            if (index != NO_PARTICLE)
+                _link(index, LIST_ACTIVE);
+            return index;
+        }
+
+        // Evicted from the pile: bring settled record `id` back into a slot
+        // on the fading list, frozen in place with the fade starting at
+        // `time`. Without a free slot the record is dropped at once.
+        void fadeSettled(u32 id, float time)
+        {
+            const u32 index = _restore(id, time);
+            if (index == NO_PARTICLE)
+            {
+                settled.remove(id);
+                return;
+            }
+            _link(index, LIST_FADING);
+        }
+
+        // Drop from every list and return the slot to the pool (left the
+        // world horizontally)
+        void release(u32 index)
+        {
+            if (list_id[index] == LIST_NONE)
+                return;
+            _unlink(index);
+            free_slots.push_back(index);
+        }
+
+    private:
+        // Free slot or a newly grown one, NO_PARTICLE if the pool is full
+        u32 _takeSlot()
+        {
+            if (!free_slots.empty())
+            {
+                const u32 index = free_slots.back();
+                free_slots.pop_back();
+                return index;
+            }
+            if (full())
+                return NO_PARTICLE;
+            _grow();
+            return static_cast<u32>(size() - 1);
+        }
+
+        // Fill a slot from settled record `id` and drop the record. The
+        // archived orientation is final, so spin (or the fade) restarts
+        // from it at `time`.
+        u32 _restore(u32 id, float time)
+        {
+            const u32 index = _takeSlot();
+            if (index == NO_PARTICLE)
+                return NO_PARTICLE;
+
+            const SettledRecord &record = settled[id];
+            pos_x[index] = settled.x(id);
+            pos_y[index] = settled.y(id);
+            vel_x[index] = 0.0f;
+            vel_y[index] = 0.0f;
+            k[index] = drag;
+            spawn_time[index] = time;
+            pitch[index] = record.pitch;
+            yaw[index] = record.yaw;
+            roll[index] = record.roll;
+            color[index] = record.color;
+            list_id[index] = LIST_NONE;
+            settled.remove(id);
+            return index;
+        }
+
+        // Append `count` zeroed slots to every per-particle array
+        void _grow(size_t count = 1)
+        {
+            const size_t n = size() + count;
+            pos_x.resize(n);
+            pos_y.resize(n);
+            vel_x.resize(n);
+            vel_y.resize(n);
+            k.resize(n);
+            spawn_time.resize(n);
+            launch_time.resize(n);
+            flight.resize(n);
+            pitch.resize(n);
+            yaw.resize(n);
+            roll.resize(n);
+            color.resize(n);
+            list_id.resize(n);
+            list_slot.resize(n);
+        }
+
+        std::vector<u32> &_list(u8 id)
+        {
+            return id == LIST_ACTIVE ? active : fading;
+        }
+
+        void _link(u32 index, u8 id)
+        {
+            std::vector<u32> &list = _list(id);
+            list_id[index] = id;
+            list_slot[index] = static_cast<u32>(list.size());
+            list.push_back(index);
+        }
+
+        // Swap the last entry into the vacated slot and pop
+        void _unlink(u32 index)
+        {
+            const u8 id = list_id[index];
+            if (id == LIST_NONE)
+                return;
+
+            std::vector<u32> &list = _list(id);
+            const u32 slot = list_slot[index];
+            const u32 last = list.back();
+            list[slot] = last;
+            list_slot[last] = slot;
+            list.pop_back();
+            list_id[index] = LIST_NONE;
+        }
+
+        size_t _capacity = 0; // 0 = unlimited
+    };
+
+} // namespace obj
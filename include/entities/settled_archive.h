@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "entities/spatial_grid.h"
+#include "utils/types.h"
+
+namespace obj
+{
+    // Positions are stored as u16 fixed point: 1/32 world unit steps from
+    // ARCHIVE_ORIGIN, covering [-256, 1792) on both axes. Anything outside
+    // is clamped to the edge.
+    constexpr float ARCHIVE_POS_STEP = 1.0f / 32.0f;
+    constexpr float ARCHIVE_ORIGIN = -256.0f;
+
+    // Returned by SettledArchive::oldest when nothing is archived
+    constexpr u32 NO_RECORD = 0xFFFFFFFFu;
+
+    // Dead records tolerated beyond one per live record before compaction
+    constexpr size_t ARCHIVE_SLACK = 4096;
+
+    // Changed ranges listed before the log gives up and reports everything
+    // as changed
+    constexpr size_t ARCHIVE_MAX_CHANGES = 8192;
+
+    // Records [first, end) of SettledArchive, by id
+    struct RecordRange
+    {
+        u32 first, end;
+    };
+
+    // What a resting piece needs to be drawn and woken: 20 bytes
+    struct SettledRecord
+    {
+        u16 x, y;             // fixed-point position, see ARCHIVE_POS_STEP
+        u16 pitch, yaw, roll; // final orientation as turn fractions
+        u16 alive;            // 0 once woken or evicted
+        u32 color;            // packed RGBA8
+        float spawn_time;     // when its last flight started (wake cool-down)
+    };
+    static_assert(sizeof(SettledRecord) == 20, "SettledRecord must stay 20B");
+
+    /**
+     * Cold storage for confetti resting on the floor
+     *
+     * A settled piece does not change until the mouse wakes it, so instead
+     * of keeping a slot in the particle store's hot arrays it is reduced to
+     * a SettledRecord here and its slot is freed. Waking rehydrates it into
+     * the store (see ParticleStore::wake).
+     *
+     * Records are appended in settle order, so the oldest live one is at the
+     * front and eviction needs no separate log. Waking or evicting a piece
+     * only marks its record dead; dead records are dropped by a compaction
+     * once they outnumber the live ones, which renumbers every record. Ids
+     * are therefore only valid until the next add().
+     *
+     * The grid indexes record ids by position for the mouse.
+     *
+     * A change log lists the records written since the last clearChanges(),
+     * dead ones included, so a mirror of the records (the renderer's
+     * retained settled buffer) can copy just those. Compaction and clear()
+     * renumber everything and are logged as allChanged().
+     */
+    struct SettledArchive
+    {
+        SpatialGrid grid;
+
+        // Live records
+        size_t size() const noexcept { return _live; }
+        bool empty() const noexcept { return _live == 0; }
+
+        const SettledRecord &operator[](u32 id) const { return _records[id]; }
+
+        // Records by id, live or dead; ids run from 0 to slots() - 1
+        size_t slots() const noexcept { return _records.size(); }
+
+        float x(u32 id) const { return decode(_records[id].x); }
+        float y(u32 id) const { return decode(_records[id].y); }
+
+        void reserve(size_t capacity)
+        {
+            _records.reserve(capacity);
+            grid.reserve(capacity);
+        }
+
+        void clear() noexcept
+        {
+            _records.clear();
+            grid.clear();
+            _head = 0;
+            _live = 0;
+            _all_changed = true;
+            _changes.clear();
+        }
+
+        // (Re)build the grid over a world of the given size
+        void configureGrid(float width, float height, float cell_size)
+        {
+            grid.configure(width, height, cell_size);
+            forEach([this](u32 id, const SettledRecord &)
+                    { grid.insert(id, x(id), y(id)); });
+        }
+
+        u32 add(float px, float py, u16 pitch, u16 yaw, u16 roll, u32 color,
+                float spawn_time)
+        {
+            if (_records.size() - _live > std::max(_live, ARCHIVE_SLACK))
+                _compact();
+
+            const u32 id = static_cast<u32>(_records.size());
+            _records.push_back({encode(px), encode(py), pitch, yaw, roll, 1,
+                                color, spawn_time});
+            grid.insert(id, x(id), y(id));
+            ++_live;
+            _changed(id);
+            return id;
+        }
+
+        void remove(u32 id)
+        {
+            SettledRecord &record = _records[id];
+            if (!record.alive)
+                return;
+            record.alive = 0;
+            grid.remove(id);
+            --_live;
+            _changed(id);
+        }
+
+        // Live record that settled first, or NO_RECORD
+        u32 oldest()
+        {
+            while (_head < _records.size() && !_records[_head].alive)
+                ++_head;
+            return _head < _records.size() ? static_cast<u32>(_head)
+                                           : NO_RECORD;
+        }
+
+        // Visit every live record in settle order as fn(id, record); fn may
+        // remove() the record it is given
+        template <typename Fn> void forEach(Fn &&fn) const
+        {
+            for (size_t n = _head; n < _records.size(); ++n)
+            {
+                if (_records[n].alive)
+                    fn(static_cast<u32>(n), _records[n]);
+            }
+        }
+
+        // ---------- change log ----------
+
+        // Every record may have changed since clearChanges(), slots() too
+        bool allChanged() const noexcept { return _all_changed; }
+
+        // Records changed since clearChanges(), unless allChanged(); in the
+        // order written, possibly overlapping
+        const std::vector<RecordRange> &changes() const noexcept
+        {
+            return _changes;
+        }
+
+        void clearChanges() noexcept
+        {
+            _changes.clear();
+            _all_changed = false;
+        }
+
+        static u16 encode(float v)
+        {
+            const float steps =
+                std::floor((v - ARCHIVE_ORIGIN) / ARCHIVE_POS_STEP + 0.5f);
+            return static_cast<u16>(std::clamp(steps, 0.0f, 65535.0f));
+        }
+
+        static float decode(u16 v)
+        {
+            return ARCHIVE_ORIGIN + static_cast<float>(v) * ARCHIVE_POS_STEP;
+        }
+
+    private:
+        void _changed(u32 id)
+        {
+            if (_all_changed)
+                return;
+            // Appends extend the last range; wakes are scattered
+            if (!_changes.empty() && _changes.back().end == id)
+                ++_changes.back().end;
+            else if (_changes.size() < ARCHIVE_MAX_CHANGES)
+                _changes.push_back({id, id + 1});
+            else
+            {
+                _all_changed = true;
+                _changes.clear();
+            }
+        }
+
+        // Drop dead records, keeping settle order, and re-index the grid
+        void _compact()
+        {
+            size_t kept = 0;
+            for (size_t n = _head; n < _records.size(); ++n)
+            {
+                if (_records[n].alive)
+                    _records[kept++] = _records[n];
+            }
+            _records.resize(kept);
+            _head = 0;
+            _all_changed = true;
+            _changes.clear();
+
+            grid.clear();
+            for (size_t n = 0; n < kept; ++n)
+            {
+                const u32 id = static_cast<u32>(n);
+                grid.insert(id, x(id), y(id));
+            }
+        }
+
+        std::vector<SettledRecord> _records; // settle order, dead included
+        size_t _head = 0;                    // records before it are dead
+        size_t _live = 0;
+
+        std::vector<RecordRange> _changes;
+        bool _all_changed = false;
+    };
+
+} // namespace obj
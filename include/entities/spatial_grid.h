@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "utils/types.h"
+
+namespace obj
+{
+    /**
+     * Uniform grid of particle indices over a fixed rectangle
+     *
+     * Every cell keeps an unordered list of the indices inside it, and every
+     * indexed particle remembers its cell and slot, so insert and remove are
+     * O(1) swap-and-pop just like the particle store's lists. Positions
+     * outside the rectangle are clamped to the border cells, which keeps
+     * queries correct for particles that poke slightly out of the world.
+     *
+     * The grid is unconfigured (and ignores inserts) until configure() is
+     * called; the owner is expected to rebuild its contents at that point.
+     */
+    struct SpatialGrid
+    {
+        static constexpr u32 NO_CELL = std::numeric_limits<u32>::max();
+
+        bool configured() const noexcept { return !_cells.empty(); }
+
+        // Lay out cells of `cell_size` over [0, width] x [0, height]; drops
+        // all indexed particles
+        void configure(float width, float height, float cell_size)
+        {
+            _cell_size = cell_size;
+            _inv_cell_size = 1.0f / cell_size;
+            _cols = std::max(1, static_cast<int>(std::ceil(width / cell_size)));
+            _rows =
+                std::max(1, static_cast<int>(std::ceil(height / cell_size)));
+            _cells.assign(static_cast<size_t>(_cols) * _rows, {});
+            std::fill(_cell_of.begin(), _cell_of.end(), NO_CELL);
+        }
+
+        // Allocate per-particle bookkeeping for indices below `count`
+        void reserve(size_t count)
+        {
+            _cell_of.reserve(count);
+            _slot_of.reserve(count);
+        }
+
+        // Drop all indexed particles, keeping the layout
+        void clear() noexcept
+        {
+            for (std::vector<u32> &cell : _cells)
+                cell.clear();
+            _cell_of.clear();
+            _slot_of.clear();
+        }
+
+        bool contains(u32 index) const noexcept
+        {
+            return index < _cell_of.size() && _cell_of[index] != NO_CELL;
+        }
+
+        void insert(u32 index, float x, float y)
+        {
+            if (!configured())
+                return;
+
+            if (index >= _cell_of.size())
+            {
+                _cell_of.resize(index + 1, NO_CELL);
+                _slot_of.resize(index + 1, 0);
+            }
+
+            const u32 cell = _cellAt(_col(x), _row(y));
+            std::vector<u32> &list = _cells[cell];
+            _cell_of[index] = cell;
+            _slot_of[index] = static_cast<u32>(list.size());
+            list.push_back(index);
+        }
+
+        void remove(u32 index)
+        {
+            if (!contains(index))
+                return;
+
+            std::vector<u32> &list = _cells[_cell_of[index]];
+            const u32 slot = _slot_of[index];
+            const u32 last = list.back();
+            list[slot] = last;
+            _slot_of[last] = slot;
+            list.pop_back();
+            _cell_of[index] = NO_CELL;
+        }
+
+        // Visit every indexed particle in a cell overlapped by the capsule
+        // around segment A-B with radius `reach`. Candidates still need an
+        // exact distance test; the grid must not be modified during the
+        // visit.
+        template <typename Fn>
+        void forEachNearSegment(float ax, float ay, float bx, float by,
+                                float reach, Fn &&fn) const
+        {
+            if (!configured())
+                return;
+
+            const int row_begin = _row(std::min(ay, by) - reach);
+            const int row_end = _row(std::max(ay, by) + reach);
+
+            for (int row = row_begin; row <= row_end; ++row)
+            {
+                // Part of the segment whose capsule reaches this row's band
+                float band_min = row * _cell_size - reach;
+                float band_max = (row + 1) * _cell_size + reach;
+                if (row == 0)
+                    band_min = -std::numeric_limits<float>::infinity();
+                if (row == _rows - 1)
+                    band_max = std::numeric_limits<float>::infinity();
+
+                float t0 = 0.0f;
+                float t1 = 1.0f;
+                const float dy = by - ay;
+                if (dy != 0.0f)
+                {
+                    float ta = (band_min - ay) / dy;
+                    float tb = (band_max - ay) / dy;
+                    if (ta > tb)
+                        std::swap(ta, tb);
+                    t0 = std::max(t0, ta);
+                    t1 = std::min(t1, tb);
+                    if (t0 > t1)
+                        continue;
+                }
+                else if (ay < band_min || ay > band_max)
+                    continue;
+
+                const float x0 = ax + (bx - ax) * t0;
+                const float x1 = ax + (bx - ax) * t1;
+                const int col_begin = _col(std::min(x0, x1) - reach);
+                const int col_end = _col(std::max(x0, x1) + reach);
+
+                for (int col = col_begin; col <= col_end; ++col)
+                {
+                    for (u32 index : _cells[_cellAt(col, row)])
+                        fn(index);
+                }
+            }
+        }
+
+    private:
+        int _col(float x) const noexcept
+        {
+            return std::clamp(static_cast<int>(std::floor(x * _inv_cell_size)),
+                              0, _cols - 1);
+        }
+
+        int _row(float y) const noexcept
+        {
+            return std::clamp(static_cast<int>(std::floor(y * _inv_cell_size)),
+                              0, _rows - 1);
+        }
+
+        u32 _cellAt(int col, int row) const noexcept
+        {
+            return static_cast<u32>(row) * _cols + col;
+        }
+
+        float _cell_size = 1.0f;
+        float _inv_cell_size = 1.0f;
+        int _cols = 0;
+        int _rows = 0;
+        std::vector<std::vector<u32>> _cells;
+        std::vector<u32> _cell_of; // per particle: cell or NO_CELL
+        std::vector<u32> _slot_of; // per particle: position inside the cell
+    };
+
+} // namespace obj
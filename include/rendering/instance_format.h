@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "entities/particles.h"
+#include "systems/sim_thread.h"
+#include "utils/globals.h"
+#include "utils/types.h"
+
+// ########## PACKED INSTANCES ##########
+//
+// What the vertex shader reads per rectangle, in 32 bytes instead of 20
+// floats:
+//
+//   position   u16 fixed point, INSTANCE_POS_STEP steps from
+//              INSTANCE_POS_ORIGIN; outside the range is clamped
+//   size       half floats
+//   color      RGBA8, normalized by the attribute
+//   angles     u16 turn fractions (see pack_angle), already turned by the
+//              spin up to the epoch (see epoch_turn)
+//   velocity   half floats, world units/s
+//   drag       half float k, 1/s
+//   time       seconds from the epoch at which position and velocity hold
+//   flags      INSTANCE_* bits
+//
+// Times are relative to an epoch, a multiple of INSTANCE_EPOCH_SECONDS,
+// so they keep a float's full precision however long the game runs; the
+// shader's clock uTime is render time minus the same epoch.
+//
+// The layout is GL-free so the headless tools can pack the same bytes.
+
+// Positions cover [-1024, 3072) on both axes in 1/16 world unit steps
+inline constexpr float INSTANCE_POS_STEP = 1.0f / 16.0f;
+inline constexpr float INSTANCE_POS_ORIGIN = -1024.0f;
+
+inline constexpr double INSTANCE_EPOCH_SECONDS = 64.0;
+
+// Flags
+inline constexpr u16 INSTANCE_ROTATE = 1 << 0;     // apply the angles
+inline constexpr u16 INSTANCE_SPIN = 1 << 1;       // and keep turning them
+inline constexpr u16 INSTANCE_MOVE = 1 << 2;       // move from time on
+inline constexpr u16 INSTANCE_BACKGROUND = 1 << 3; // fill its size exactly
+
+struct PackedInstance
+{
+    u16 x, y;             // position, see INSTANCE_POS_STEP
+    u16 width, height;    // size, half floats
+    u32 color;            // RGBA8, see pack_rgba8
+    u16 pitch, yaw, roll; // orientation at the epoch
+    u16 k;                // drag coefficient, half float
+    u16 vel_x, vel_y;     // velocity, half floats
+    float time;           // time of position and velocity, from the epoch
+    u16 flags;            // INSTANCE_* bits
+    u16 unused;
+};
+static_assert(sizeof(PackedInstance) == 32, "PackedInstance must stay 32B");
+
+// ========== Field encodings ==========
+
+// IEEE half float, rounded to nearest even; out of range becomes infinity
+inline u16 pack_half(float value)
+{
+    u32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const u16 sign = static_cast<u16>((bits >> 16) & 0x8000u);
+    bits &= 0x7FFFFFFFu;
+
+    if (bits >= 0x477FF000u) // 65520 and up round to infinity; NaN stays
+        return sign | (bits > 0x7F800000u ? 0x7E00u : 0x7C00u);
+
+    if (bits < 0x38800000u) // below the smallest normal half
+    {
+        // Adding 0.5 lines the subnormal's bits up at the bottom of the
+        // mantissa, and the FPU rounds them
+        float shifted;
+        std::memcpy(&shifted, &bits, sizeof(shifted));
+        shifted += 0.5f;
+        std::memcpy(&bits, &shifted, sizeof(bits));
+        return sign | static_cast<u16>(bits - 0x3F000000u);
+    }
+
+    // Rebias the exponent and round the mantissa to 10 bits
+    const u32 rounded = bits + 0xFFFu + ((bits >> 13) & 1u);
+    return sign | static_cast<u16>((rounded - 0x38000000u) >> 13);
+}
+
+inline u16 pack_instance_pos(float v)
+{
+    const float steps =
+        std::floor((v - INSTANCE_POS_ORIGIN) / INSTANCE_POS_STEP + 0.5f);
+    return static_cast<u16>(std::clamp(steps, 0.0f, 65535.0f));
+}
+
+// Epoch for instances drawn at `time`
+inline double instance_epoch(double time)
+{
+    return std::floor(time / INSTANCE_EPOCH_SECONDS) * INSTANCE_EPOCH_SECONDS;
+}
+
+// Turn to add to the angles of a piece spinning at `spin` rad/s since
+// spawn_time: up to the epoch while it spins (the shader turns it on from
+// there), or its whole turn once it stopped spinning at stop_time (> 0)
+inline u16 epoch_turn(float spin, double epoch, float spawn_time,
+                      float stop_time)
+{
+    const double end = stop_time > 0.0f ? stop_time : epoch;
+    return pack_angle(static_cast<float>(
+        std::fmod(spin * (end - spawn_time), static_cast<double>(TWO_PI))));
+}
+
+// ========== Confetti ==========
+
+// Piece n of the snapshot's flying arrays
+inline void pack_flying(const SimSnapshot &frame, size_t n, double epoch,
+                        PackedInstance &out)
+{
+    const bool spinning = frame.stop_time[n] <= 0.0f;
+    const u16 turn = epoch_turn(ROTATION_SPEED, epoch, frame.spawn_time[n],
+                                frame.stop_time[n]);
+
+    out.x = pack_instance_pos(frame.pos_x[n]);
+    out.y = pack_instance_pos(frame.pos_y[n]);
+    out.width = pack_half(RECT_WIDTH);
+    out.height = pack_half(RECT_HEIGHT);
+    out.color = frame.color[n];
+    out.pitch = static_cast<u16>(frame.pitch[n] + turn);
+    out.yaw = static_cast<u16>(frame.yaw[n] + turn);
+    out.roll = static_cast<u16>(frame.roll[n] + turn);
+    out.k = pack_half(frame.k[n]);
+    out.vel_x = pack_half(frame.vel_x[n]);
+    out.vel_y = pack_half(frame.vel_y[n]);
+    out.time = static_cast<float>(frame.state_time[n] - epoch);
+    out.flags = INSTANCE_ROTATE | (spinning ? INSTANCE_SPIN : 0) |
+                (frame.moving[n] ? INSTANCE_MOVE : 0);
+    out.unused = 0;
+}
+
+// An archived piece: still, at its final orientation, independent of the
+// epoch. Dead records get no size and draw nothing.
+inline PackedInstance pack_settled(const obj::SettledRecord &record)
+{
+    const float size = record.alive ? 1.0f : 0.0f;
+
+    PackedInstance out;
+    out.x = pack_instance_pos(obj::SettledArchive::decode(record.x));
+    out.y = pack_instance_pos(obj::SettledArchive::decode(record.y));
+    out.width = pack_half(RECT_WIDTH * size);
+    out.height = pack_half(RECT_HEIGHT * size);
+    out.color = record.color;
+    out.pitch = record.pitch;
+    out.yaw = record.yaw;
+    out.roll = record.roll;
+    out.k = 0;
+    out.vel_x = out.vel_y = 0;
+    out.time = 0.0f;
+    out.flags = INSTANCE_ROTATE;
+    out.unused = 0;
+    return out;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+/**
+ * Persistently mapped ring of per-frame instance regions
+ *
+ * One buffer object holds RING_REGIONS regions of `capacity` instances
+ * each. It is created with glBufferStorage and mapped once, persistent and
+ * coherent, so instance data is written by the CPU straight into memory
+ * the GPU reads: no staging copy, no glBufferSubData and no driver-side
+ * copy or orphaning.
+ *
+ * Every frame takes the next region. A fence placed after the frame's last
+ * draw tells when the GPU is done with it; the region is only written
+ * again three frames later, after waiting on that fence, so the CPU never
+ * overwrites data a queued draw still reads and never waits on the draw it
+ * just issued. Within a frame, allocations are handed out back to back,
+ * so draws of several layers never share bytes either.
+ *
+ * A frame that needs more than a region holds grows the ring: a new,
+ * larger buffer replaces the old one, which GL keeps alive until the draws
+ * using it have finished.
+ */
+class InstanceRing
+{
+public:
+    static constexpr int RING_REGIONS = 3;
+
+    // Room handed out by allocate(): write `count` instances at `data`, then
+    // bind buffer() at `offset` (bytes) for the draw
+    struct Span
+    {
+        void *data = nullptr;
+        GLintptr offset = 0;
+        size_t count = 0;
+    };
+
+    InstanceRing() = default;
+    ~InstanceRing();
+
+    InstanceRing(const InstanceRing &) = delete;
+    InstanceRing &operator=(const InstanceRing &) = delete;
+
+    // Regions of `capacity` instances of `stride` bytes, growing up to
+    // `max_capacity`. Needs GL 4.4 (ARB_buffer_storage); false without it.
+    bool create(size_t stride, size_t capacity, size_t max_capacity);
+    void destroy();
+
+    // Move to the next region, waiting for the GPU if it still reads it
+    void beginFrame();
+
+    // Room for `count` instances in this frame's region, fewer if the ring
+    // is at max_capacity and full
+    Span allocate(size_t count);
+
+    // Fence this frame's region after its last draw
+    void endFrame();
+
+    GLuint buffer() const noexcept { return _buffer; }
+    size_t stride() const noexcept { return _stride; }
+    size_t capacity() const noexcept { return _capacity; }
+
+    // Frames that found their region still in use, and the time spent
+    // waiting for it in seconds
+    size_t stalls() const noexcept { return _stalls; }
+    double stallSeconds() const noexcept { return _stall_seconds; }
+
+private:
+    bool _allocate(size_t capacity);
+    void _waitRegion(int region);
+
+    GLuint _buffer = 0;
+    unsigned char *_mapped = nullptr;
+    size_t _stride = 0;
+    size_t _capacity = 0; // instances per region
+    size_t _max_capacity = 0;
+
+    GLsync _fences[RING_REGIONS] = {};
+    int _region = RING_REGIONS - 1; // region of the current frame
+    size_t _used = 0;               // instances handed out this frame
+
+    size_t _stalls = 0;
+    double _stall_seconds = 0.0;
+};
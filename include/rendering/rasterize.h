@@ -1,7 +1,11 @@
 #pragma once
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
 #include "utils/globals.h"
 
 #include "entities/objects.h"
+#include "systems/sim_thread.h"
 
 // Initialize the rasterizer (sets up shaders, buffers, etc.)
 bool rasterize_init();
@@ -35,5 +39,14 @@ void batch_draw_rectangles(const std::vector<obj::Rectangle *> &rectangles);
 void instanced_draw_rectangles(const std::vector<obj::Rectangle *> &rectangles,
                                bool isBackground);
 
+// Bracket the instanced draws of a frame. `frame` supplies their clock and
+// physics parameters and must outlive them; the end fences the frame's
+// instance data, so call it after the last instanced draw.
+void begin_instanced_frame(const SimSnapshot &frame);
+void end_instanced_frame();
+
+// Instanced rendering of the confetti captured in a snapshot
+void instanced_draw_particles(const SimSnapshot &frame);
+
 // Debug function to draw red dots at rectangle centers
 void draw_center_dots(const std::vector<obj::Rectangle *> &rectangles);
@@ -1,69 +1,82 @@
 const char *vertexShaderSource = R"(
 #version 460 core
 layout (location = 0) in vec2 aPos;        // Base rectangle vertex position (0-1 range)
-layout (location = 1) in vec2 aOffset;     // Per-instance INITIAL position offset (world coordinates)
-layout (location = 2) in vec2 aSize;       // Per-instance size (world coordinates)
-layout (location = 3) in vec4 aColor;      // Per-instance color (RGBA)
-layout (location = 4) in vec3 aAngles;     // Per-instance INITIAL rotation angles (pitch, yaw, roll in radians)
-layout (location = 5) in vec2 aVelocity;   // Per-instance velocity (world units per second)
-layout (location = 6) in float aSpawnTime; // Per-instance spawn time (seconds)
-layout (location = 7) in float aStopTime; // Per-instance spawn time (seconds)
-layout (location = 8) in vec2 aFlags;      // Per-instance flags (x=should_rotate, y=move)
-layout (location = 9) in float aIsBackground;    // Padding to make size multiple of vec4
+
+// Per-instance data, packed (see rendering/instance_format.h)
+layout (location = 1) in vec2 aOffset;     // Position in fixed-point steps (uPosStep from uPosOrigin)
+layout (location = 2) in vec2 aSize;       // Size (world coordinates)
+layout (location = 3) in vec4 aColor;      // Color (RGBA)
+layout (location = 4) in vec3 aAngles;     // Rotation angles at the epoch (pitch, yaw, roll in turn steps)
+layout (location = 5) in vec2 aVelocity;   // Velocity (world units per second)
+layout (location = 6) in float aDrag;      // Drag k (1/s)
+layout (location = 7) in float aLaunch;    // Time of aOffset/aVelocity (seconds from the epoch)
+layout (location = 8) in uint aFlags;      // INSTANCE_* bits
+
+const uint FLAG_ROTATE = 1u;
+const uint FLAG_SPIN = 2u;
+const uint FLAG_MOVE = 4u;
+const uint FLAG_BACKGROUND = 8u;
+const float ANGLE_STEP = 6.28318530718 / 65536.0;
 
 // Trig table texture and size
 uniform sampler1D uTrigTable;
 uniform float uTrigTableSize;
 
 // Time and rotation speed for GPU-side angle calculation
-uniform float uTime;           // Current time in seconds
+uniform float uTime;           // Current time in seconds from the epoch
 uniform float uRotationSpeed;  // Rotation speed in radians per second
 
 uniform float uVelocityChange; // Gravity or other velocity change factor
+uniform float uAnalyticMotion; // 1 when aOffset/aVelocity are launch states
 
 // World coordinate system uniforms for GPU-side conversion
 uniform vec2 uScreenSize;     // Screen width and height
 uniform float uWorldScale;    // Scale factor from world to screen coordinates
 uniform vec2 uWorldOffset;    // Offset for centering world in screen
+uniform float uPosOrigin;     // World coordinate of position step 0
+uniform float uPosStep;       // World units per position step
 
 out vec4 vertexColor;
 
 // Function to look up sin/cos from the trig table
 vec2 lookupTrig(float angle) {
-    // Normalize angle to [0, 2π] range
-    float normalized = mod(angle, 6.28318530718); // 2*PI
-    if (normalized < 0.0) normalized += 6.28318530718;
-    
-    // Convert to texture coordinate [0, 1]
-    float texCoord = normalized / 6.28318530718;
-    
+    // One turn maps to [0, 1); the texture repeats, so any angle wraps
+    // without a branch. Half a texel rounds to the nearest entry.
+    float texCoord = angle * 0.15915494309 + 0.5 / uTrigTableSize; // 1/(2*PI)
+
     // Lookup in texture (Red = sin, Green = cos)
     return texture(uTrigTable, texCoord).rg;
 }
 
 void main()
 {
-    // Calculate elapsed time since spawn for this specific rectangle
-    float dt = 0.0;
-    if (aStopTime > 0.0) {
-        dt = aStopTime - aSpawnTime; // Time since spawn until stop
-    } else {
-        // If not stopped, use current time
-        dt = uTime - aSpawnTime; // Time since spawn
-    }
+    // The angles hold the spin up to the epoch (or all of it once the
+    // piece stopped), so a spinning piece only turns on from there
+    float dt = (aFlags & FLAG_SPIN) != 0u ? uTime : 0.0;
+    bool moving = (aFlags & FLAG_MOVE) != 0u;
 
     // Center the base vertex position around (0,0) before rotation
     // aPos goes from (0,0) to (1,1), so center it to (-0.5,-0.5) to (0.5,0.5)
     vec2 centeredPos = aPos - vec2(0.5);
     
-    // Calculate current position using initial position + (velocity * elapsed_time)
-    // This moves the movement calculation to the GPU based on spawn time!
-    // Only apply movement if the move flag is enabled (aFlags.y > 0.5)
-    vec2 currentWorldPos = aOffset;
-    // if (aFlags.y > 0.5) {
-    //     vec2 aVelocity = aVelocity + vec2(0.0f, uVelocityChange * dt); // Apply velocity change factor (e.g., gravity)
-    //     currentWorldPos += aVelocity * dt;
-    // }
+    // In analytic mode airborne pieces carry their launch state and the
+    // closed-form drag + gravity flight (systems/trajectory.h) is evaluated
+    // here. Otherwise aOffset is the position after the latest step, and
+    // moving along aVelocity to uTime interpolates between fixed steps.
+    vec2 currentWorldPos = uPosOrigin + aOffset * uPosStep;
+    if (uAnalyticMotion < 0.5 && moving) {
+        currentWorldPos += aVelocity * (uTime - aLaunch);
+    }
+    if (uAnalyticMotion > 0.5 && moving) {
+        float tau = max(uTime - aLaunch, 0.0);
+        float k = aDrag;
+        if (k < 1e-6) {
+            currentWorldPos += aVelocity * tau + vec2(0.0, 0.5 * uVelocityChange * tau * tau);
+        } else {
+            vec2 terminal = vec2(0.0, uVelocityChange / k);
+            currentWorldPos += terminal * tau + (aVelocity - terminal) * (1.0 - exp(-k * tau)) / k;
+        }
+    }
     
     // Convert world coordinates to screen coordinates
     vec2 screenPos = (currentWorldPos * uWorldScale) + uWorldOffset;
@@ -78,7 +91,7 @@ void main()
     
     // Apply uniform scaling only for objects that should maintain square proportions
     // Background rectangles (should_rotate=false, move=false) should fill their intended dimensions
-    if (aIsBackground < 0.5) {
+    if ((aFlags & FLAG_BACKGROUND) == 0u) {
         // Ensure squares stay square by using the same scale factor for both dimensions
         // Take the minimum to ensure we don't overflow the screen
         float uniformScale = min(ndcSize.x / aSize.x, ndcSize.y / aSize.y);
@@ -88,14 +101,15 @@ void main()
     // Scale first using NDC size
     vec2 scaledPos = centeredPos * ndcSize;
     
-    // Calculate rotation only if should_rotate flag is enabled (aFlags.x > 0.5)
+    // Calculate rotation only if the rotate flag is set
     vec2 finalPos = scaledPos;
-    if (aFlags.x > 0.5) {
-        // Calculate current angles based on initial angles + (rotation_speed * elapsed_time)
+    if ((aFlags & FLAG_ROTATE) != 0u) {
+        // Calculate current angles based on the angles at the epoch + (rotation_speed * elapsed_time)
         // This moves the angle increment calculation to the GPU based on spawn time!
-        float currentPitch = aAngles.x + (uRotationSpeed * dt);
-        float currentYaw = aAngles.y + (uRotationSpeed * dt);
-        float currentRoll = aAngles.z + (uRotationSpeed * dt);
+        vec3 angles = aAngles * ANGLE_STEP + uRotationSpeed * dt;
+        float currentPitch = angles.x;
+        float currentYaw = angles.y;
+        float currentRoll = angles.z;
         
         // Look up trigonometric values from GPU table using current angles
         vec2 pitchTrig = lookupTrig(currentPitch);  // pitch (X-axis rotation)
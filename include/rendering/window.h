@@ -1,7 +1,9 @@
 #pragma once
 
+#include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "entities/objects.h"
+#include "systems/sim_thread.h"
 
 #ifdef _WIN32
 // Force dedicated GPU usage on Windows systems with hybrid graphics
@@ -20,8 +22,9 @@ extern "C" {
 
 std::pair<bool, GLFWwindow*> window_init();
 
-// Render function that handles the entire frame rendering
-void render_frame(float& fps);
+// Render function that handles the entire frame rendering, drawing the
+// confetti of `frame`
+void render_frame(float& fps, const SimSnapshot& frame);
 
 // Cleanup function to properly dispose of rendering resources
 void window_cleanup();
\ No newline at end of file
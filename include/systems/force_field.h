@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "systems/integrate.h"
+#include "utils/types.h"
+
+// ########## FORCE FIELDS ##########
+//
+// Wind, vortices, attractors and turbulence acting on airborne confetti.
+// Once per frame build_force_field() composites every enabled field into
+// the acceleration at the nodes of a coarse grid over the world; during
+// the step the integration kernel reads each particle's acceleration back
+// with a bilinear sample (see ForceGrid in systems/integrate.h). The
+// per-particle cost is therefore the same for one field or a hundred, and a
+// field only touches the grid nodes it reaches.
+//
+// Wind, vortices and turbulence describe moving air: the particle is pulled
+// towards the air's velocity by the same linear drag that slows it down,
+// a = k * v_air. Attractors are a plain acceleration.
+//
+// Fields act on integrated flights only. Analytic flights (MotionMode::
+// Analytic) follow the closed-form drag and gravity trajectory and ignore
+// them.
+
+enum class FieldKind : u8
+{
+    Wind,       // uniform air velocity `strength` along `direction`
+    Vortex,     // air swirling around (x, y), fastest halfway out
+    Attractor,  // pull towards (x, y); negative strength pushes away
+    Turbulence  // divergence-free gusts over the whole world
+};
+
+struct FieldConfig
+{
+    FieldKind kind = FieldKind::Wind;
+    float x = 0.0f, y = 0.0f; // center in world units (vortex, attractor)
+
+    // Wind, vortex, turbulence: air speed in world units/s
+    // Attractor: acceleration in world units/s² at the center
+    // Vortex: positive turns clockwise on screen (y points down)
+    float strength = 40.0f;
+
+    float radius = 120.0f;    // reach of a vortex or attractor
+    float direction = 0.0f;   // wind direction in radians, y down
+    float scale = 96.0f;      // turbulence feature size in world units
+    float rate = 0.5f;        // how fast turbulence changes, in 1/s
+
+    bool enabled = true;
+};
+
+// Add a field and return its id (never 0)
+u32 add_force_field(const FieldConfig &config);
+
+// Forget a field; false if the id is unknown
+bool remove_force_field(u32 id);
+
+void clear_force_fields();
+size_t force_field_count();
+void set_force_field_enabled(u32 id, bool enabled);
+
+// Edge length of the grid cells in world units (default 16). Takes effect
+// at the next build.
+void set_force_field_cell_size(float cell_size);
+
+// Composite the enabled fields at `time` into the grid, which spans the
+// current world size. simulation_step does this at the start of every
+// integrated step.
+void build_force_field(double time);
+
+// Whether the last build had any enabled field
+bool force_field_active();
+
+// Acceleration at a point from the last build, in world units/s². Points
+// outside the world take the value at the nearest edge.
+void sample_force_field(float x, float y, float &ax, float &ay);
+
+// The grid of the last build for integrate_particles, or null when no
+// field is enabled. Valid until the next build.
+const ForceGrid *force_grid();
+
+// ========== Config ==========
+//
+// A kind followed by key=value pairs, in the style of the emitter config:
+//
+//     wind speed=30 dir=0
+//     vortex x=360 y=240 radius=150 speed=80
+//     attractor x=200 y=300 radius=200 strength=-400
+//     turbulence speed=25 scale=120 rate=0.3
+//
+// `speed` and `strength` both set FieldConfig::strength, angles are in
+// degrees and unknown keys are errors.
+bool parse_field_config(const std::string &text, FieldConfig &config);
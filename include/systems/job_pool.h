@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed-size thread pool for data-parallel loops
+ *
+ * parallelFor() cuts [0, count) into chunks and deals them out as one
+ * contiguous run of chunks per worker. Every worker claims chunks from the
+ * front of its own run through an atomic cursor. Once its run is
+ * exhausted, it steals from the other runs the same way. Claiming a chunk
+ * is a single fetch_add, with no locks on the hot path.
+ *
+ * The calling thread takes part as worker 0, so a pool of size N starts
+ * N - 1 threads. Worker indices passed to the body are stable within a call
+ * and lie in [0, size()), which lets callers keep per-worker scratch
+ * buffers without synchronisation.
+ */
+class JobPool
+{
+public:
+    // Range body: fn(begin, end, worker)
+    using RangeFn = std::function<void(size_t, size_t, unsigned)>;
+
+    // thread_count == 0 uses std::thread::hardware_concurrency()
+    explicit JobPool(unsigned thread_count = 0);
+    ~JobPool();
+
+    JobPool(const JobPool &) = delete;
+    JobPool &operator=(const JobPool &) = delete;
+
+    // Number of workers including the calling thread
+    unsigned size() const noexcept { return _worker_count; }
+
+    // Run fn over [0, count) in chunks of at most `chunk` elements and
+    // return once every chunk has finished
+    void parallelFor(size_t count, size_t chunk, const RangeFn &fn);
+
+private:
+    // One worker's run of chunks, padded to avoid false sharing
+    struct alignas(64) ChunkRun
+    {
+        std::atomic<size_t> next{0}; // next chunk to claim
+        size_t end = 0;              // one past the last chunk of this run
+    };
+
+    void _workerLoop(unsigned worker);
+    void _drain(unsigned worker);
+
+    unsigned _worker_count = 1;
+    std::vector<std::thread> _threads;
+    std::unique_ptr<ChunkRun[]> _runs;
+
+    // Current job, published under _mutex
+    const RangeFn *_fn = nullptr;
+    size_t _count = 0;
+    size_t _chunk = 1;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    size_t _generation = 0;
+    unsigned _busy = 0;
+    bool _stopping = false;
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "utils/types.h"
+
+// ########## MOUSE INTERACTION ##########
+//
+// Every cursor sample since the previous frame is kept with its timestamp,
+// and the frame's path is the polyline through them, starting where the
+// last frame's path ended. Each segment sweeps a capsule (grown by the
+// mouse and particle radii), so a fast flick is tested along the way the
+// cursor actually went instead of on a straight cut between two polls.
+// Particles inside a capsule are pushed out along the normal from its
+// segment and, if they are in front of the cursor's motion, along that
+// motion as well. A particle is pushed by the first capsule that reaches it.
+//
+// Settled and airborne particles share one stage: the caller gathers
+// candidate positions from whatever index it has (settled grid, active
+// list, analytic flights), mouse_push_batch() evaluates all of them in one
+// branch-free pass and returns the hits. Every cursor gets its own capsule.
+
+// One cursor's sweep this frame; build with make_mouse_capsule()
+struct MouseCapsule
+{
+    float ax, ay;   // previous cursor position
+    float bx, by;   // current cursor position
+    float sx, sy;   // b - a
+    float inv_len2; // 1 / |b - a|², 0 for a still cursor
+    float radius;   // mouse radius + particle radius
+    float vx, vy;   // cursor velocity (world units per second)
+    float speed;
+    float dt; // seconds between the two cursor samples
+
+    // Bounding box of the capsule
+    float min_x, max_x, min_y, max_y;
+
+    bool mayContain(float x, float y) const noexcept
+    {
+        return x >= min_x && x <= max_x && y >= min_y && y <= max_y;
+    }
+};
+
+MouseCapsule make_mouse_capsule(float prev_x, float prev_y, float x, float y,
+                                float sample_dt, float particle_radius);
+
+// Samples closer than this to the previous one are dropped, so a slow or
+// resting cursor does not stack up overlapping capsules
+inline constexpr float MOUSE_SAMPLE_SPACING = 1.0f;
+
+// Samples kept per frame; beyond that the newest replaces the last one
+inline constexpr size_t MOUSE_PATH_MAX_SAMPLES = 256;
+
+// Record the cursor at world position (x, y) at time t (seconds). Called
+// for every cursor event.
+void record_mouse_sample(float x, float y, float t);
+
+// Forget all samples, e.g. when the cursor leaves the window
+void reset_mouse_path();
+
+// The capsules of one frame's cursor path, in the order they were swept
+struct MousePath
+{
+    std::vector<MouseCapsule> capsules;
+
+    // Bounding box of all capsules
+    float min_x, max_x, min_y, max_y;
+
+    bool empty() const noexcept { return capsules.empty(); }
+
+    bool mayContain(float x, float y) const noexcept
+    {
+        return x >= min_x && x <= max_x && y >= min_y && y <= max_y;
+    }
+};
+
+// Build the path swept since the previous call from the recorded samples
+// and start collecting the next one. A cursor that has not moved gives a
+// single still capsule at its position; one never seen gives no capsules.
+void take_mouse_path(float particle_radius, MousePath &path);
+
+// Positions to test against a capsule, as parallel arrays
+struct MouseCandidates
+{
+    std::vector<u32> index;
+    std::vector<float> x;
+    std::vector<float> y;
+
+    size_t size() const noexcept { return index.size(); }
+
+    void clear() noexcept
+    {
+        index.clear();
+        x.clear();
+        y.clear();
+    }
+
+    void add(u32 i, float px, float py)
+    {
+        index.push_back(i);
+        x.push_back(px);
+        y.push_back(py);
+    }
+};
+
+// Velocity change for one particle inside the capsule
+struct MousePush
+{
+    u32 index;
+    float dvx, dvy;
+    u16 segment; // capsule of the path that reached it
+    u8 in_front; // 1 if the cursor is moving towards the particle
+};
+
+// Evaluate every candidate against `capsule` and append a push for each one
+// inside it to `out`, tagged with `segment`
+void mouse_push_batch(const MouseCapsule &capsule,
+                      const MouseCandidates &candidates,
+                      std::vector<MousePush> &out, u16 segment);
+
+// Per-caller working memory of mouse_push_path
+struct MousePathScratch
+{
+    MouseCandidates subset;  // candidates near the current capsule
+    std::vector<u8> pending; // per candidate: not pushed yet
+
+    // Candidates binned by cell of a grid over the path: cell c holds
+    // binned[cell_start[c], cell_start[c + 1])
+    std::vector<u32> cell_start;
+    std::vector<u32> binned;
+    std::vector<u32> cell_of; // per candidate
+    std::vector<u32> cursor;  // per cell, while binning
+    std::vector<u32> near;    // candidates in the current capsule's cells
+};
+
+// Evaluate candidates against every capsule of the path in order and append
+// one push per candidate, from the first capsule that reaches it. The
+// candidates are binned once into a grid of capsule-sized cells over the
+// path, and each capsule only visits the cells its bounding box overlaps,
+// so the cost follows the swept area rather than segments x candidates.
+// Each capsule's pushes come out in candidate order.
+void mouse_push_path(const MousePath &path, const MouseCandidates &candidates,
+                     MousePathScratch &scratch, std::vector<MousePush> &out);
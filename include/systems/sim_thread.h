@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "entities/settled_archive.h"
+#include "utils/types.h"
+
+// ########## SIMULATION THREAD ##########
+//
+// The simulation can run on a thread of its own, one frame ahead of the
+// render thread: while frame N is packed and presented, frame N + 1 is
+// simulated. The two sides share nothing but two channels:
+//
+//   render -> simulation  SimInput events (cursor samples, clicks, keys),
+//                         queued and applied at the start of the next frame
+//   simulation -> render  a SimSnapshot of everything the renderer draws,
+//                         handed over through a lock-free triple buffer
+//
+// Everything else belongs to the simulation thread while it runs: the
+// particle store, force fields, emitters, the mouse path and the clock
+// state. The renderer reads only the snapshot.
+//
+// Without the thread, request_simulation_frame() runs the frame on the
+// calling thread, so the same code path works single-threaded.
+
+// ========== Input ==========
+
+struct SimInput
+{
+    enum class Kind : u8
+    {
+        Burst,       // `count` pieces at (x, y)
+        MouseSample, // cursor at (x, y) at time t
+        HoldSpawn,   // start (on) or stop the cursor emitter of a held click
+        Call         // run `call` on the simulation thread
+    };
+
+    Kind kind;
+    float x = 0.0f, y = 0.0f; // world units
+    float t = 0.0f;
+    u32 count = 0;
+    bool on = false;
+    void (*call)() = nullptr;
+
+    static SimInput burst(float x, float y, u32 count)
+    {
+        return {Kind::Burst, x, y, 0.0f, count};
+    }
+
+    static SimInput mouseSample(float x, float y, float t)
+    {
+        return {Kind::MouseSample, x, y, t};
+    }
+
+    static SimInput holdSpawn(bool on)
+    {
+        return {Kind::HoldSpawn, 0.0f, 0.0f, 0.0f, 0, on};
+    }
+
+    // For rare commands (clear, toggles); fn must only touch simulation state
+    static SimInput run(void (*fn)())
+    {
+        return {Kind::Call, 0.0f, 0.0f, 0.0f, 0, false, fn};
+    }
+};
+
+// Queue an input for the next simulation frame. Any thread.
+void post_simulation_input(const SimInput &input);
+
+// ========== Snapshot ==========
+
+// One frame as the renderer sees it
+struct SimSnapshot
+{
+    // Pieces in flight or fading, in draw order, as parallel arrays
+    std::vector<float> pos_x, pos_y;
+    std::vector<float> vel_x, vel_y;
+    std::vector<float> state_time; // time pos/vel belong to
+    std::vector<float> spawn_time, stop_time;
+    std::vector<float> k;
+    std::vector<u32> color;
+    std::vector<u16> pitch, yaw, roll;
+    std::vector<u8> moving;
+
+    // Pieces resting on the floor. The renderer keeps its own copy of the
+    // archive's records, one slot per record id, dead ones included (see
+    // obj::SettledArchive), so a snapshot carries only the records changed
+    // since the snapshot the renderer last took: settled_changes holds the
+    // records of settled_ranges, range after range. latest_snapshot() tells
+    // the simulation which snapshot that is, so the changes of a snapshot
+    // the renderer skipped come again with the next one. Applying a change
+    // twice is harmless.
+    size_t settled = 0;           // live records
+    u32 settled_slots = 0;        // records, live or dead
+    bool settled_rebuild = false; // ranges cover every slot: start over
+    std::vector<obj::RecordRange> settled_ranges;
+    std::vector<obj::SettledRecord> settled_changes;
+
+    double render_time = 0.0; // shader clock, see render_time()
+    float gravity = 0.0f;     // gravity_acceleration()
+    float drag = 0.0f;        // ParticleStore::drag
+    bool analytic = false;    // MotionMode::Analytic
+
+    // For display
+    size_t active = 0;
+    size_t budget = 0;
+    u64 frame = 0;            // request it answered, from 1
+    float sim_seconds = 0.0f; // wall time the simulation spent on it
+
+    size_t flying() const noexcept { return pos_x.size(); }
+    size_t size() const noexcept { return flying() + settled; }
+};
+
+// Copy the current simulation state into `out`, reusing its storage, as
+// the snapshot of `frame`
+void capture_snapshot(SimSnapshot &out, u64 frame);
+
+// Newest snapshot published, or an empty one before the first frame.
+// Render thread only; valid until its next call. The caller must apply the
+// settled changes of every snapshot it gets.
+const SimSnapshot &latest_snapshot();
+
+// ========== Frames ==========
+
+// Start / stop the simulation thread. Stopping finishes the frame in
+// progress; queued inputs stay queued.
+void start_simulation_thread();
+void stop_simulation_thread();
+bool simulation_thread_running();
+
+// Ask for the next frame: apply the queued inputs, advance_simulation() to
+// the clock and publish a snapshot. Returns at once with the thread
+// running (requests made while a frame is in progress fold into one more
+// frame); runs the frame before returning without it.
+void request_simulation_frame();
+
+// Block until every requested frame has been published
+void wait_simulation_frame();
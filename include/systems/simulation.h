@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstddef>
+
+#include "utils/types.h"
+
+class JobPool;
+
+// Windowless simulation core: everything here runs without GLFW or OpenGL so
+// the physics can be stepped and measured on machines without a display.
+
+// ========== Clock ==========
+
+// Returns the current time in seconds
+using SimClock = double (*)();
+
+// Install the clock used for spawn/stop timestamps (the game passes
+// glfwGetTime, the headless runner a scripted clock). nullptr restores the
+// default steady clock.
+void set_simulation_clock(SimClock clock);
+
+// Current time according to the installed clock, less the time dropped by
+// the fixed stepper to recover from hitches
+double simulation_time();
+
+// ========== Fixed Step ==========
+//
+// The game advances the physics in steps of a fixed length instead of by
+// the frame time: advance_simulation() runs every step that has come due on
+// the clock since the last call, and the renderer draws the state
+// interpolated between the last two steps. Cost and behaviour no longer
+// depend on the display rate. After a stall longer than max_substeps steps
+// the backlog is dropped instead of replayed, so a hitch pauses the
+// confetti rather than launching it.
+
+// Length of one step in seconds and the most steps run by one call
+// (defaults 1/60 and 8). Non-positive values keep the current setting.
+void set_fixed_step(double seconds, int max_substeps);
+double fixed_step();
+int max_substeps();
+
+struct AdvanceResult
+{
+    int steps = 0;        // steps run
+    size_t emitted = 0;   // pieces spawned by emitters during those steps
+    double dropped = 0.0; // seconds skipped to stay within max_substeps
+};
+
+// Run the due steps, each one updating the emitters and calling
+// simulation_step at the step's own time. The first call only starts the
+// clock.
+AdvanceResult advance_simulation();
+
+// Time of the most recent step
+double last_step_time();
+
+// How far the clock has moved into the next step, in [0, 1)
+float step_alpha();
+
+// Time the renderer shows: the previous step plus step_alpha() of a step,
+// which is one step behind the clock. Integrated pieces are drawn at
+// pos + vel * (render_time() - time of the step that produced pos/vel),
+// which is exactly the interpolation between the last two steps.
+double render_time();
+
+// ========== Threading ==========
+
+// Number of workers (including the calling thread) used to update large
+// active populations; 0 uses every hardware thread
+void set_simulation_threads(unsigned thread_count);
+unsigned simulation_threads();
+
+// Those workers, for other bulk work on the simulation thread such as large
+// spawns; created on first use
+JobPool &physics_pool();
+
+// ========== Motion ==========
+
+enum class MotionMode : u8
+{
+    Integrated, // step drag and gravity every frame
+    Analytic    // closed-form flights from a stored launch state
+};
+
+// In analytic mode an airborne particle's pos/vel are its launch state at
+// launch_time; its position at any time comes from systems/trajectory.h on
+// the CPU and the same expression in the vertex shader. The step only acts
+// on particles the mouse touches and flights whose predicted end has come.
+// Switching modes converts every airborne particle in place.
+void set_motion_mode(MotionMode mode);
+MotionMode motion_mode();
+
+// Launch times are stored as float seconds after this time, which the step
+// moves up to the clock every few minutes, so they keep their precision
+// however long the simulation has run. Add it back for an absolute time.
+double launch_time_origin();
+
+// Gravity in world units/s² currently applied to airborne confetti
+float gravity_acceleration();
+
+// Record pos/vel of particle `index` as launched at `time` and predict where
+// its flight ends; spawners call this after ParticleStore::add
+void launch_particle(u32 index, double time);
+
+// launch_particle for indices[0, count) in one pass; used after
+// ParticleStore::addBulk
+void launch_particles(const u32 *indices, size_t count, double time);
+
+// Position and velocity of particle `index` at `time`, whatever the mode
+void particle_state_at(u32 index, double time, float &x, float &y, float &vx,
+                       float &vy);
+
+// ========== Level of Detail ==========
+//
+// In integrated mode the active list is split into blocks of 64 entries,
+// and each block is stepped every step, every 2nd or every 4th. A slow
+// block takes one long step instead of the short ones it skipped. The tier
+// is picked whenever the block is stepped, from its fastest piece's motion
+// in pixels at the current zoom, and from how far a long step would bend
+// off the short ones. Blocks that could reach the floor before they are
+// next due stay at full rate. Blocks above the visible area skip the speed
+// limit. Blocks are phased by their index, so every step advances an even
+// share of each tier. The mouse brings every block it may reach up to date
+// before it pushes.
+//
+// Each piece's launch_time holds the time its pos/vel belong to, which the
+// renderer extrapolates from. Swap-and-pop moves pieces between blocks.
+// A piece whose time differs from its new block's is stepped on its own,
+// in short steps, when that block is next due.
+//
+// On by default. Switching it off, or to analytic motion, first brings
+// every piece up to the latest step.
+void set_lod_enabled(bool enabled);
+bool lod_enabled();
+
+// Airborne pieces the latest step advanced: all of them without level of
+// detail, none in analytic mode
+size_t stepped_particles();
+
+// Drop every piece of confetti together with the flight events queued for
+// them. Use this instead of ParticleStore::clear() once pieces have been
+// launched, or a due event reads a slot that no longer exists.
+void clear_simulation();
+
+// ========== Budget ==========
+
+// Most confetti allowed in the active and settled lists together; 0 uses the
+// whole pool. Spawning past the budget evicts the oldest settled pieces
+// first (by stop_time) and airborne ones only when no settled piece is left.
+void set_particle_budget(size_t max_particles);
+size_t particle_budget();
+
+// Evicted pieces fade out over this many seconds before their slot is freed;
+// 0 removes them at once
+void set_eviction_fade(float seconds);
+float eviction_fade();
+
+// Make room for `count` new pieces and return how many may be spawned
+// (fewer only if the pool itself is exhausted)
+size_t reserve_particles(size_t count, double current_time);
+
+// Advance fades of evicted pieces and free the finished ones (called by
+// simulation_step)
+void update_fading_particles(double current_time);
+
+// ========== Spawn ==========
+
+// Where and how a batch of confetti is launched
+struct SpawnParams
+{
+    enum class Shape : u8
+    {
+        Point, // at (x0, y0)
+        Line,  // uniformly on the segment (x0, y0)-(x1, y1)
+        Area   // uniformly in the rectangle with corners (x0, y0), (x1, y1)
+    };
+
+    Shape shape = Shape::Point;
+    float x0 = 0.0f, y0 = 0.0f, x1 = 0.0f, y1 = 0.0f;
+
+    // Launch angle uniform in direction ± spread / 2, in radians with y
+    // pointing down (-π/2 is straight up); a spread of 2π is every direction
+    float direction = 0.0f;
+    float spread = TWO_PI;
+
+    // Launch speed uniform in [speed_min, speed_max) world units/s
+    float speed_min = 0.0f;
+    float speed_max = 0.0f;
+
+    // Piece n leaves at first_time + n * interval; pieces that left before
+    // the spawn time are advanced along their flight to it. 0 launches the
+    // whole batch at the spawn time.
+    double first_time = 0.0;
+    double interval = 0.0;
+};
+
+// Spawn `count` pieces described by `params` at `time`: the budget is made
+// room for, the slots are taken in one go and the launch state is generated
+// in bulk, across the physics job pool for large batches. Returns how many
+// pieces were spawned.
+size_t spawn_pieces(const SpawnParams &params, size_t count, double time);
+
+// Spawn a burst of `count` confetti pieces at (x, y) in world units, all
+// launched at `time` in random directions with the click explosion's speeds
+size_t spawn_burst(float x, float y, size_t count, double time);
+
+// ========== Step ==========
+
+// Advance all confetti by dt seconds: mouse interaction with settled and
+// airborne pieces, drag, gravity, floor settling and dropping pieces that
+// leave the world horizontally
+void simulation_step(double dt, double current_time);
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+
+// ########## CLOSED-FORM TRAJECTORY ##########
+//
+// Airborne confetti obeys dv/dt = -k v + (0, g): linear drag plus constant
+// gravity. With launch state (p0, v0) the exact solution tau seconds later is
+//
+//     e    = exp(-k tau)
+//     v_t  = (0, g / k)                          terminal velocity
+//     v    = v_t + (v0 - v_t) e
+//     p    = p0 + v_t tau + (v0 - v_t) (1 - e) / k
+//
+// The vertex shader evaluates the same expression, so the CPU and GPU agree
+// on where an untouched particle is without any per-frame state.
+
+// Below this drag the k -> 0 limit (ballistic motion) is used
+inline constexpr float TRAJECTORY_MIN_DRAG = 1e-6f;
+
+// Position and velocity tau seconds after launch
+inline void trajectory_at(float x0, float y0, float vx0, float vy0, float k,
+                          float g, float tau, float &x, float &y, float &vx,
+                          float &vy)
+{
+    if (k < TRAJECTORY_MIN_DRAG)
+    {
+        x = x0 + vx0 * tau;
+        y = y0 + (vy0 + 0.5f * g * tau) * tau;
+        vx = vx0;
+        vy = vy0 + g * tau;
+        return;
+    }
+
+    const float e = std::exp(-k * tau);
+    const float decay = (1.0f - e) / k;
+    const float v_t = g / k;
+
+    x = x0 + vx0 * decay;
+    y = y0 + v_t * tau + (vy0 - v_t) * decay;
+    vx = vx0 * e;
+    vy = v_t + (vy0 - v_t) * e;
+}
+
+// Seconds after launch until the flight ends, or +inf if it never does. A
+// flight ends when y reaches floor_y (lands = true) or x leaves
+// [min_x, max_x] (lands = false), whichever comes first.
+inline double trajectory_end(float x0, float y0, float vx0, float vy0, float k,
+                             float g, float floor_y, float min_x, float max_x,
+                             bool &lands)
+{
+    constexpr double NEVER = std::numeric_limits<double>::infinity();
+    const double kd = k < TRAJECTORY_MIN_DRAG ? 0.0 : k;
+
+    // ---------- floor ----------
+    // y(tau) is unimodal: y' = v_t + (vy0 - v_t) e^(-k tau) changes sign at
+    // most once, so after the apex y only increases and Newton converges
+    auto y_at = [&](double tau)
+    {
+        if (kd == 0.0)
+            return y0 + (vy0 + 0.5 * g * tau) * tau;
+        const double v_t = g / kd;
+        return y0 + v_t * tau + (vy0 - v_t) * (1.0 - std::exp(-kd * tau)) / kd;
+    };
+    auto vy_at = [&](double tau)
+    {
+        if (kd == 0.0)
+            return vy0 + g * tau;
+        const double v_t = g / kd;
+        return v_t + (vy0 - v_t) * std::exp(-kd * tau);
+    };
+
+    double land = NEVER;
+    if (y0 >= floor_y)
+    {
+        land = 0.0;
+    }
+    else
+    {
+        // Apex (where vy turns positive), if the particle is rising
+        double tau = 0.0;
+        if (vy0 < 0.0f && g > 0.0f)
+        {
+            tau = kd == 0.0 ? -vy0 / static_cast<double>(g)
+                            : std::log((g / kd - vy0) / (g / kd)) / kd;
+        }
+
+        // Never comes down: no gravity and the drift stalls above the floor
+        const bool reaches = kd == 0.0 ? (g > 0.0f || vy0 > 0.0f)
+                                       : (g > 0.0f || y0 + vy0 / kd > floor_y);
+        if (reaches)
+        {
+            // Step out until past the floor, then safeguarded Newton
+            // inside the bracket [lo, hi]
+            double step = 0.25;
+            while (y_at(tau + step) < floor_y && step < 1e6)
+                step *= 2.0;
+            double lo = tau;
+            double hi = tau + step;
+            double x = hi;
+
+            for (int it = 0; it < 50 && hi - lo > 1e-9; ++it)
+            {
+                const double fx = y_at(x) - floor_y;
+                if (std::abs(fx) < 1e-6)
+                    break;
+                if (fx < 0.0)
+                    lo = x;
+                else
+                    hi = x;
+
+                const double slope = vy_at(x);
+                double next = slope > 0.0 ? x - fx / slope : lo;
+                if (next <= lo || next >= hi)
+                    next = 0.5 * (lo + hi);
+                x = next;
+            }
+            land = x;
+        }
+    }
+
+    // ---------- sides ----------
+    // x(tau) moves monotonically towards x0 + vx0 / k
+    double exit = NEVER;
+    if (x0 < min_x || x0 > max_x)
+    {
+        exit = 0.0;
+    }
+    else if (vx0 != 0.0f)
+    {
+        const double wall = vx0 > 0.0f ? max_x : min_x;
+        const double distance = wall - x0;
+        if (kd == 0.0)
+        {
+            exit = distance / vx0;
+        }
+        else
+        {
+            const double q = distance * kd / vx0; // 1 - e^(-k tau)
+            if (q < 1.0)
+                exit = -std::log1p(-q) / kd;
+        }
+    }
+
+    lands = land <= exit;
+    return lands ? land : exit;
+}
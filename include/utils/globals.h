@@ -5,37 +5,15 @@
 #include <cmath>
 #include <cstdint>
 #include <cstring>
-#include <glad/glad.h>
-#include <glfw/glfw3.h>
 #include <iostream>
 #include <map>
 #include <memory>
-#include <random>
 #include <string>
 #include <utility>
 #include <vector>
 
-// ########## MATHEMATICAL CONSTANTS ##########
-
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-inline constexpr static float TWO_PI = 2.0f * static_cast<float>(M_PI);
-inline constexpr static float INV_TWO_PI = 1.0f / TWO_PI;
-
-// ########## TYPE ALIASES ##########
-
-// Integer types with explicit size and range comments
-using u8 = uint8_t;   // 0-255 range - for colors, small counters
-using u16 = uint16_t; // 0-65k range - for dimensions, entity IDs
-using u32 = uint32_t; // 0-4B range - for large calculations
-using i16 = int16_t;  // -32k to +32k range - for screen coordinates
-using i32 = int32_t;  // Signed 32-bit for offset calculations
-
-// Matrix types for transformations
-using Mat2 = std::array<float, 4>;
-using Mat3 = std::array<float, 9>;
+#include "utils/random.h"
+#include "utils/types.h"
 
 // ########## FORWARD DECLARATIONS ##########
 template <typename T> struct Color;
@@ -43,6 +21,7 @@ template <typename T> struct Color;
 namespace obj
 {
     struct Rectangle;
+    struct ParticleStore;
 
 }
 
@@ -97,13 +76,14 @@ extern const float
     WORLD_TO_METERS; // Conversion factor from world units to meters
 
 // ########## RANDOM NUMBER GENERATION ##########
-extern std::mt19937 random_engine;
-extern std::uniform_real_distribution<float>
-    random_angle; // Random angle distribution
-extern std::uniform_real_distribution<float>
-    random_radius; // Random radius distribution
-extern std::uniform_real_distribution<float>
-    random_impuls_increase; // Random decay variation
+// Counter-based generator behind spawns and mouse flicks; seeded from the OS
+// at startup unless seed_random() is called
+extern CounterRng random_engine;
+extern const float RANDOM_IMPULS_MIN; // Explosion strength variation range
+extern const float RANDOM_IMPULS_MAX;
+
+// Restart the generator so the run is reproducible
+void seed_random(u64 seed);
 
 // ########## GRAPHICS AND RENDERING ##########
 
@@ -135,10 +115,14 @@ extern float world_offset_y; // Y offset for screen positioning
 
 // Rectangle storage and rendering
 extern std::vector<std::vector<obj::Rectangle *>> render_order;
-extern std::vector<std::unique_ptr<obj::Rectangle>> rectangles;
-extern std::vector<obj::Rectangle *> activeRects;
-extern std::vector<obj::Rectangle *> settledRects;
 extern int rectangle_count;
+extern const u32 CLICK_SPAWN_COUNT; // confetti pieces per click
+
+// Confetti storage (owns the active / settled index lists)
+extern const u32 PARTICLE_CAPACITY; // fixed pool size, bursts stop when full
+extern const u32 PARTICLE_BUDGET;   // default live limit, oldest evicted first
+extern const float EVICTION_FADE;   // default fade-out of evicted pieces (s)
+extern obj::ParticleStore particles;
 extern std::unique_ptr<obj::Rectangle> world_background;
 
 extern size_t layer_background;
@@ -158,38 +142,39 @@ extern float mouse_current_x;
 extern float mouse_current_y;
 extern float mouse_world_x;
 extern float mouse_world_y;
-extern float mouse_world_x_prev;
-extern float mouse_world_y_prev;
-extern float mouse_last_t;
-extern float mouse_current_t;
+extern float mouse_current_t; // time of the last cursor event
+// The cursor path between frames is recorded with record_mouse_sample()
+// (systems/mouse_interaction.h)
 extern double mouse_hold_duration; // Duration in seconds
 
 // ########## PERFORMANCE OPTIMIZATION ##########
 
 // ========== Trigonometry Look-up Tables ==========
 
-extern std::vector<std::pair<float, float>> trig_table; // (sin, cos) pairs
-extern size_t trig_table_size;
-extern std::vector<Mat2> mat_table;
+// trig_table, mat_table and the branchless lookups are built at compile
+// time in utils/trig_table.h; include it where they are used
 
 // ########## FUNCTION DECLARATIONS ##########
 
 // ========== Entity Creation ==========
 
-// Spawn rectangles at specified position
+// Spawn rectangles at specified position (screen coordinates)
 void spawn_rectangles(float x, float y);
 
+// Spawn rectangles at a position in world coordinates
+void spawn_rectangles_world(float world_x, float world_y);
+
 // ========== Input Processing ==========
 
 // Mouse hold utility functions
 void update_mouse_hold_duration(double delta_time);
-void handle_mouse_hold_continuous();
 
-// ========== Performance Utilities ==========
+// Render thread: ask the simulation to start or stop the hold spawn once the
+// left button has been held long enough or is released
+void handle_mouse_hold_continuous();
 
-// Trigonometry optimization
-void precompute_trig_angles();
-size_t angle_to_index(float angle);
+// Simulation thread: run or pause the cursor emitter of a held click
+void set_hold_spawn(bool on);
 
 // ========== Coordinate Transformations ==========
 
@@ -1,4 +1,6 @@
 #pragma once
+#include <GLFW/glfw3.h>
+
 #include "utils/globals.h"
 
 void key_callback(GLFWwindow *window, int key, int scancode, int action,
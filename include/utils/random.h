@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "utils/types.h"
+
+// ########## COUNTER-BASED RANDOM NUMBERS ##########
+//
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2,
+// 3"): ten rounds of a keyed bijection on a 128-bit counter. Output block n
+// of a stream is a pure function of (seed, stream, n), so blocks can be made
+// in any order, on any thread or several at a time, and two runs with the
+// same seed draw the same numbers bit for bit.
+
+using PhiloxBlock = std::array<u32, 4>;
+
+inline constexpr PhiloxBlock philox4x32(u64 counter, u64 stream, u64 key)
+{
+    u32 c0 = static_cast<u32>(counter);
+    u32 c1 = static_cast<u32>(counter >> 32);
+    u32 c2 = static_cast<u32>(stream);
+    u32 c3 = static_cast<u32>(stream >> 32);
+    u32 k0 = static_cast<u32>(key);
+    u32 k1 = static_cast<u32>(key >> 32);
+
+    for (int round = 0; round < 10; ++round)
+    {
+        const u64 p0 = static_cast<u64>(0xD2511F53u) * c0;
+        const u64 p1 = static_cast<u64>(0xCD9E8D57u) * c2;
+        const u32 n0 = static_cast<u32>(p1 >> 32) ^ c1 ^ k0;
+        const u32 n2 = static_cast<u32>(p0 >> 32) ^ c3 ^ k1;
+        c1 = static_cast<u32>(p1);
+        c3 = static_cast<u32>(p0);
+        c0 = n0;
+        c2 = n2;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    return {c0, c1, c2, c3};
+}
+
+// Float in [0, 1) from the top 24 bits
+inline constexpr float unit_float(u32 bits)
+{
+    return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+}
+
+// ========== Bulk Blocks ==========
+
+// Defined in systems/integrate.h
+enum class SimdLevel : u8;
+
+// Blocks [first, first + blocks) of a stream, four outputs per block in
+// order. The vector backends run four (SSE2) or eight (AVX2) counters at
+// once, one per lane, and return the same bits as philox4x32.
+void philox_fill(u32 *out, u64 first, size_t blocks, u64 stream, u64 key);
+
+// Backend used by philox_fill (defaults to detect_simd_level()); requests
+// above what the CPU supports are clamped
+void set_philox_backend(SimdLevel level);
+SimdLevel philox_backend();
+
+// One float in [0, 1) for `counter` without any generator state, e.g. keyed
+// by particle index so the result does not depend on visiting order
+inline constexpr float counter_unit_float(u64 key, u64 stream, u64 counter)
+{
+    return unit_float(philox4x32(counter, stream, key)[0]);
+}
+
+/**
+ * Sequential view of one Philox stream
+ *
+ * Hands out the stream's 32-bit outputs in order, four per counter value.
+ * The fill functions return exactly what the same number of next calls
+ * would, but compute whole blocks with philox_fill, several at a time.
+ */
+struct CounterRng
+{
+    explicit CounterRng(u64 seed = 0, u64 stream = 0)
+        : _key(seed), _stream(stream)
+    {
+    }
+
+    // Restart stream `stream` of `seed` from its first output
+    void seed(u64 seed, u64 stream = 0)
+    {
+        _key = seed;
+        _stream = stream;
+        _counter = 0;
+        _used = 4;
+    }
+
+    u64 key() const noexcept { return _key; }
+    u64 stream() const noexcept { return _stream; }
+
+    // Outputs handed out since the stream was (re)started
+    u64 position() const noexcept { return 4 * _counter - (4 - _used); }
+
+    // Continue from output `position` of the stream, as if exactly that many
+    // had been drawn. Lets several copies fill disjoint parts of one
+    // sequence, e.g. on different threads.
+    void seek(u64 position)
+    {
+        _counter = position / 4;
+        _used = 4;
+        if (position % 4 != 0)
+        {
+            _block = philox4x32(_counter++, _stream, _key);
+            _used = static_cast<u32>(position % 4);
+        }
+    }
+
+    u32 nextU32()
+    {
+        if (_used == 4)
+        {
+            _block = philox4x32(_counter++, _stream, _key);
+            _used = 0;
+        }
+        return _block[_used++];
+    }
+
+    // Uniform in [0, 1) and [lo, hi)
+    float nextFloat() { return unit_float(nextU32()); }
+    float uniform(float lo, float hi) { return lo + (hi - lo) * nextFloat(); }
+
+    void fillU32(u32 *out, size_t count)
+    {
+        size_t n = 0;
+
+        // Finish the current block first
+        while (n < count && _used < 4)
+            out[n++] = _block[_used++];
+
+        const size_t blocks = (count - n) / 4;
+        philox_fill(out + n, _counter, blocks, _stream, _key);
+        _counter += blocks;
+        n += 4 * blocks;
+
+        while (n < count)
+            out[n++] = nextU32();
+    }
+
+    void fillUniform(float *out, size_t count, float lo, float hi)
+    {
+        constexpr size_t CHUNK = 256;
+        u32 bits[CHUNK];
+        const float scale = hi - lo;
+
+        for (size_t n = 0; n < count; n += CHUNK)
+        {
+            const size_t chunk = count - n < CHUNK ? count - n : CHUNK;
+            fillU32(bits, chunk);
+            for (size_t j = 0; j < chunk; ++j)
+                out[n + j] = lo + scale * unit_float(bits[j]);
+        }
+    }
+
+private:
+    u64 _key;
+    u64 _stream;
+    u64 _counter = 0;
+    PhiloxBlock _block = {};
+    u32 _used = 4; // outputs of _block already handed out
+};
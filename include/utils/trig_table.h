@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "utils/types.h"
+
+// ########## TRIGONOMETRY LOOK-UP TABLES ##########
+//
+// sin and cos of evenly spaced angles over one turn, generated by the
+// compiler so nothing is computed at startup. The sizes are powers of two:
+// any angle, negative or many turns around, maps to its nearest entry with
+// a multiply, a floor and a mask, without branches, so lookups can sit
+// inside loops the compiler vectorizes.
+
+// 8192 entries, one every 0.00077 rad
+inline constexpr u32 TRIG_TABLE_BITS = 13;
+inline constexpr u32 TRIG_TABLE_SIZE = 1u << TRIG_TABLE_BITS;
+inline constexpr u32 TRIG_TABLE_MASK = TRIG_TABLE_SIZE - 1;
+inline constexpr float TRIG_INDEX_SCALE = TRIG_TABLE_SIZE / TWO_PI;
+
+// 1024 rotation matrices, one every 0.0061 rad
+inline constexpr u32 MAT_TABLE_BITS = 10;
+inline constexpr u32 MAT_TABLE_SIZE = 1u << MAT_TABLE_BITS;
+inline constexpr u32 MAT_TABLE_MASK = MAT_TABLE_SIZE - 1;
+inline constexpr float MAT_INDEX_SCALE = MAT_TABLE_SIZE / TWO_PI;
+
+// Separate sin and cos arrays (SoA), so a batch reads each one contiguously
+// or with a single gather
+struct TrigTable
+{
+    std::array<float, TRIG_TABLE_SIZE> sin;
+    std::array<float, TRIG_TABLE_SIZE> cos;
+};
+
+namespace trig_detail
+{
+    // sin of x in [0, π/2] by its Taylor series to x^23 (error < 1e-17)
+    constexpr double quarter_sin(double x)
+    {
+        const double x2 = x * x;
+        double sum = 0.0;
+        double term = x;
+        for (int n = 1; n <= 23; n += 2)
+        {
+            sum += term;
+            term *= -x2 / ((n + 1) * (n + 2));
+        }
+        return sum;
+    }
+
+    // Only the first quarter turn is evaluated; the rest follows from the
+    // symmetries of sin, and cos is sin a quarter turn later. This keeps
+    // the constant evaluation cheap for every translation unit.
+    constexpr TrigTable make_trig_table()
+    {
+        constexpr u32 QUARTER = TRIG_TABLE_SIZE / 4;
+        constexpr double STEP = 6.28318530717958647692 / TRIG_TABLE_SIZE;
+
+        std::array<float, QUARTER + 1> quarter{};
+        for (u32 j = 0; j <= QUARTER; ++j)
+            quarter[j] = static_cast<float>(quarter_sin(j * STEP));
+
+        TrigTable table{};
+        for (u32 i = 0; i < TRIG_TABLE_SIZE; ++i)
+        {
+            const u32 j = i % QUARTER;
+            switch (i / QUARTER)
+            {
+            case 0:
+                table.sin[i] = quarter[j];
+                break;
+            case 1:
+                table.sin[i] = quarter[QUARTER - j];
+                break;
+            case 2:
+                table.sin[i] = -quarter[j];
+                break;
+            default:
+                table.sin[i] = -quarter[QUARTER - j];
+                break;
+            }
+        }
+        for (u32 i = 0; i < TRIG_TABLE_SIZE; ++i)
+            table.cos[i] = table.sin[(i + QUARTER) & TRIG_TABLE_MASK];
+        return table;
+    }
+} // namespace trig_detail
+
+inline constexpr TrigTable trig_table = trig_detail::make_trig_table();
+
+// Row-major 2x2 rotations {cos, -sin, sin, cos}, sampled from trig_table
+inline constexpr std::array<Mat2, MAT_TABLE_SIZE> mat_table = []
+{
+    constexpr u32 STRIDE = TRIG_TABLE_SIZE / MAT_TABLE_SIZE;
+
+    std::array<Mat2, MAT_TABLE_SIZE> table{};
+    for (u32 i = 0; i < MAT_TABLE_SIZE; ++i)
+    {
+        const float s = trig_table.sin[i * STRIDE];
+        const float c = trig_table.cos[i * STRIDE];
+        table[i] = {c, -s, s, c};
+    }
+    return table;
+}();
+
+// ========== Lookup ==========
+
+// Nearest of `mask + 1` entries per turn for any |angle| below ~1e6 rad.
+// floor(t) is a truncation corrected by one for negative t, which keeps
+// the function free of branches and calls.
+inline u32 wrap_angle_index(float angle, float steps_per_radian, u32 mask)
+{
+    const float t = angle * steps_per_radian + 0.5f;
+    const i32 truncated = static_cast<i32>(t);
+    const i32 floored =
+        truncated - static_cast<i32>(t < static_cast<float>(truncated));
+    return static_cast<u32>(floored) & mask;
+}
+
+inline u32 angle_to_index(float angle)
+{
+    return wrap_angle_index(angle, TRIG_INDEX_SCALE, TRIG_TABLE_MASK);
+}
+
+inline void trig_lookup(float angle, float &s, float &c)
+{
+    const u32 i = angle_to_index(angle);
+    s = trig_table.sin[i];
+    c = trig_table.cos[i];
+}
+
+// trig_lookup over arrays; the index math vectorizes everywhere and the
+// table reads become gathers where the target has them (AVX2)
+inline void trig_lookup_batch(const float *angle, size_t count, float *sin_out,
+                              float *cos_out)
+{
+    for (size_t n = 0; n < count; ++n)
+    {
+        const u32 i = angle_to_index(angle[n]);
+        sin_out[n] = trig_table.sin[i];
+        cos_out[n] = trig_table.cos[i];
+    }
+}
+
+inline const Mat2 &rotation_matrix(float angle)
+{
+    return mat_table[wrap_angle_index(angle, MAT_INDEX_SCALE, MAT_TABLE_MASK)];
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+
+#include "utils/types.h"
+
+/**
+ * Lock-free hand-over of whole values from one writer thread to one reader
+ *
+ * Three slots: the writer fills its back slot and publishes it, the reader
+ * draws from its front slot, and the third sits in between holding the
+ * newest published value. Publishing and acquiring each swap a slot with
+ * the middle one in a single atomic exchange, so neither side ever waits
+ * for the other. A reader slower than the writer skips values; a faster
+ * one keeps the value it has.
+ *
+ * Slots are reused, never reallocated: a T holding vectors keeps their
+ * capacity from one round to the next.
+ */
+template <typename T> class TripleBuffer
+{
+public:
+    // ========== Writer ==========
+
+    // Slot to fill; still holds whatever was written to it three rounds ago
+    T &back() noexcept { return _slots[_back]; }
+
+    // Make the back slot the newest value and take the middle one in its
+    // place
+    void publish() noexcept
+    {
+        const u8 previous =
+            _middle.exchange(_back | FRESH, std::memory_order_acq_rel);
+        _back = previous & INDEX;
+    }
+
+    // ========== Reader ==========
+
+    // Switch to the newest published value, if any arrived since the last
+    // call; true if the front slot changed
+    bool acquire() noexcept
+    {
+        if (!(_middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        const u8 previous = _middle.exchange(_front, std::memory_order_acq_rel);
+        _front = previous & INDEX;
+        return true;
+    }
+
+    const T &front() const noexcept { return _slots[_front]; }
+
+private:
+    static constexpr u8 INDEX = 3; // slot index in the low bits of _middle
+    static constexpr u8 FRESH = 4; // set while the middle slot is unread
+
+    T _slots[3];
+
+    // Each index is only touched by its own side, on separate cache lines
+    alignas(64) u8 _back = 0;
+    alignas(64) std::atomic<u8> _middle{1};
+    alignas(64) u8 _front = 2;
+};
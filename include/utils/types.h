@@ -0,0 +1,29 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+// ########## MATHEMATICAL CONSTANTS ##########
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+inline constexpr static float TWO_PI = 2.0f * static_cast<float>(M_PI);
+inline constexpr static float INV_TWO_PI = 1.0f / TWO_PI;
+
+// ########## TYPE ALIASES ##########
+
+// Integer types with explicit size and range comments
+using u8 = uint8_t;   // 0-255 range - for colors, small counters
+using u16 = uint16_t; // 0-65k range - for dimensions, entity IDs
+using u32 = uint32_t; // 0-4B range - for large calculations
+using u64 = uint64_t; // Full 64-bit range - for seeds and counters
+using i16 = int16_t;  // -32k to +32k range - for screen coordinates
+using i32 = int32_t;  // Signed 32-bit for offset calculations
+using i64 = int64_t;  // Signed 64-bit for wide intermediate values
+
+// Matrix types for transformations
+using Mat2 = std::array<float, 4>;
+using Mat3 = std::array<float, 9>;
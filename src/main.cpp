@@ -9,6 +9,8 @@
 #include "imgui_impl_opengl3.h"
 
 #include "rendering/window.h"
+#include "systems/sim_thread.h"
+#include "systems/simulation.h"
 
 // Error callback for GLFW
 void error_callback(int error, const char *description)
@@ -20,15 +22,6 @@ int main()
 {
     std::cout << "Initializing GLFW and OpenGL..." << std::endl;
 
-    // precompute
-    // sine
-    // and
-    // cosine
-    // values
-    // for
-    // angles
-    precompute_trig_angles();
-
     // Set
     // error
     // callback
@@ -148,6 +141,12 @@ int main()
     std::cout << "  ESC   - Close the window" << std::endl;
     std::cout << "  V     - Toggle VsyncW" << std::endl;
 
+    // The simulation reads time through its injectable clock, from its own
+    // thread from here on; it only hears from this one through
+    // post_simulation_input()
+    set_simulation_clock(glfwGetTime);
+    start_simulation_thread();
+
     // Simple
     // FPS
     // tracking
@@ -155,10 +154,6 @@ int main()
     double last_frame_time = last_time; // Track time for frame delta
     int frame_count = 0;
     float fps = 0.0f;
-    std::vector<obj::Rectangle *> to_remove; // move to settled
-    std::vector<obj::Rectangle *> to_add;    // move to active
-    std::vector<obj::Rectangle *>
-        to_remove_active_only; // drop from active only
     // float
     // age
     // =
@@ -199,314 +194,19 @@ int main()
         }
 
         // === PHYSICS-BASED SIMULATION ===
-        obj::BCircle bbox = {};
-        obj::Rectangle *rect = nullptr;
-        float cx, cy, seg_vx, seg_vy, seg_len2;
-        float dt_mouse = mouse_current_t - mouse_last_t;
-        float vx_mouse = (mouse_world_x - mouse_world_x_prev) / dt_mouse;
-        float vy_mouse = (mouse_world_y - mouse_world_y_prev) / dt_mouse;
-        float speed_mouse =
-            std::sqrt(vx_mouse * vx_mouse + vy_mouse * vy_mouse);
-        const float OUT_OFFSET = 1.0f;
-        const float OFFSET_TIME =
-            1.0f; // Time in seconds to smoothly push rectangle out
-        const float EPS = 1e-6f;
-
-        for (size_t i = 0; i < settledRects.size(); ++i)
-        {
-            rect = settledRects[i];
-            if (rect->move)
-                continue; // Skip if rectangle is already moving
-
-            closest_point_on_segment(mouse_world_x_prev, mouse_world_y_prev,
-                                     mouse_world_x, mouse_world_y,
-                                     rect->bbox.center.x, rect->bbox.center.y,
-                                     cx, cy, seg_vx, seg_vy, seg_len2);
-
-            float dx = rect->bbox.center.x - cx;
-            float dy = rect->bbox.center.y - cy;
-            float dist = std::sqrt(dx * dx + dy * dy);
-            float radius = MOUSE_RADIUS + rect->bbox.radius;
-
-            // only correct if inside the swept circle
-            if (dist < radius && rect->spawn_time + 1.f < current_time)
-            {
-                float nx, ny;
-                if (dist > EPS)
-                {
-                    // normal from closest point to particle
-                    nx = dx / dist;
-                    ny = dy / dist;
-
-                    // Calculate required velocity to smoothly push rectangle
-                    // out of mouse radius, scaled by mouse speed for fast
-                    // movements
-                    float target_distance = radius + OUT_OFFSET;
-                    float current_distance = dist;
-                    float distance_to_travel =
-                        target_distance - current_distance;
-
-                    // Base velocity needed to reach target in OFFSET_TIME
-                    float base_velocity = distance_to_travel / OFFSET_TIME;
-
-                    // Scale the pushing force based on mouse speed to handle
-                    // fast movements, but cap it to prevent skyrocketing
-                    float mouse_speed_factor =
-                        speed_mouse * 0.05f; // Reduced sensitivity
-                    float mouse_speed_multiplier =
-                        1.0f + std::min(mouse_speed_factor,
-                                        RECT_SIM_WIDTH); // Cap at 3x max
-                    float required_velocity =
-                        base_velocity * mouse_speed_multiplier;
-
-                    // Apply the velocity in the normal direction (away from
-                    // mouse)
-                    rect->velocity.x += nx * required_velocity;
-                    rect->velocity.y += ny * required_velocity;
-                }
-
-                // Only apply push force to rectangles that are "in front" of
-                // mouse movement
-                if (speed_mouse > EPS) // Only if mouse is actually moving
-                {
-                    float penetration = (radius - dist) / radius; // 0..1
-
-                    // Normalize mouse velocity vector
-                    float mvx = vx_mouse / speed_mouse;
-                    float mvy = vy_mouse / speed_mouse;
-
-                    // Vector from mouse position to rectangle center
-                    float to_rect_x = rect->bbox.center.x - mouse_world_x;
-                    float to_rect_y = rect->bbox.center.y - mouse_world_y;
-                    float to_rect_len = std::sqrt(to_rect_x * to_rect_x +
-                                                  to_rect_y * to_rect_y);
-
-                    if (to_rect_len > EPS)
-                    {
-                        // Normalize vector to rectangle
-                        to_rect_x /= to_rect_len;
-                        to_rect_y /= to_rect_len;
-
-                        // Calculate dot product: positive means rectangle is
-                        // "in front" of mouse movement
-                        float dot_product = mvx * to_rect_x + mvy * to_rect_y;
-
-                        // Only apply force if rectangle is in front
-                        // (dot_product > 0) Use the dot product as a multiplier
-                        // to scale force based on alignment
-                        if (dot_product > 0.0f)
-                        {
-                            float force_magnitude = speed_mouse * dt_mouse *
-                                                    penetration * MOUSE_MASS *
-                                                    dot_product;
-
-                            rect->velocity.x += mvx * force_magnitude;
-                            rect->velocity.y += mvy * force_magnitude;
-                            float randFactor =
-                                0.01f + (rand() / (float)RAND_MAX) * 0.5f;
-
-                            float multi = speed_mouse * dt_mouse * MOUSE_MASS;
-
-                            rect->velocity.y -= multi * randFactor;
-                            rect->velocity.x += mvx * multi * 0.5f;
-                        }
-                    }
-                }
-
-                // move rectangle back to active list
-                rect->move = true;
-                rect->stop_time = 0.0f;
-                rect->spawn_time = current_time;
-                to_add.push_back(rect);
-            }
-        }
-
-        // Move selected rectangles from settled -> active by pointer
-        if (!to_add.empty())
-        {
-            for (auto *r : to_add)
-            {
-                activeRects.push_back(r);
-            }
-            // Erase by pointer to avoid index invalidation issues
-            for (auto *r : to_add)
-            {
-                auto it =
-                    std::remove(settledRects.begin(), settledRects.end(), r);
-                if (it != settledRects.end())
-                    settledRects.erase(it, settledRects.end());
-            }
-            to_add.clear();
-        }
-
-        for (size_t i = 0; i < activeRects.size(); ++i)
-        {
-            rect = activeRects[i];
-            if (!rect->move)
-                continue; // Skip if rectangle is not moving
-
-            // rect->k = 0.5 * rho * Cd * A / mass
-            float damping = std::exp(-rect->k * dt);
-
-            rect->velocity *= damping;
-
-            // Gravity in m/s²
-            if (apply_gravity)
-                rect->velocity.y +=
-                    GRAVITY_ACCELERATION * (RECT_WIDTH + 1) * dt;
-
-            closest_point_on_segment(mouse_world_x_prev, mouse_world_y_prev,
-                                     mouse_world_x, mouse_world_y,
-                                     rect->bbox.center.x, rect->bbox.center.y,
-                                     cx, cy, seg_vx, seg_vy, seg_len2);
-
-            float dx = rect->bbox.center.x - cx;
-            float dy = rect->bbox.center.y - cy;
-            float dist = std::sqrt(dx * dx + dy * dy);
-            float radius = MOUSE_RADIUS + rect->bbox.radius;
-
-            // only correct if inside the swept circle
-            if (dist < radius && rect->spawn_time + 1.f < current_time)
-            {
-                float nx, ny;
-                if (dist > EPS)
-                {
-                    // normal from closest point to particle
-                    nx = dx / dist;
-                    ny = dy / dist;
-
-                    // Calculate required velocity to smoothly push rectangle
-                    // out of mouse radius, scaled by mouse speed for fast
-                    // movements
-                    float target_distance = radius + OUT_OFFSET;
-                    float current_distance = dist;
-                    float distance_to_travel =
-                        target_distance - current_distance;
-
-                    // Base velocity needed to reach target in OFFSET_TIME
-                    float base_velocity = distance_to_travel / OFFSET_TIME;
-
-                    // Scale the pushing force based on mouse speed to handle
-                    // fast movements, but cap it to prevent skyrocketing
-                    float mouse_speed_factor =
-                        speed_mouse * 0.05f; // Reduced sensitivity
-                    float mouse_speed_multiplier =
-                        1.0f + std::min(mouse_speed_factor,
-                                        RECT_SIM_WIDTH); // Cap at 3x max
-                    float required_velocity =
-                        base_velocity * mouse_speed_multiplier;
-
-                    // Apply the velocity in the normal direction (away from
-                    // mouse)
-                    rect->velocity.x += nx * required_velocity;
-                    rect->velocity.y += ny * required_velocity;
-                }
-
-                // Only apply push force to rectangles that are "in front" of
-                // mouse movement
-                if (speed_mouse > EPS) // Only if mouse is actually moving
-                {
-                    float penetration = (radius - dist) / radius; // 0..1
-
-                    // Normalize mouse velocity vector
-                    float mvx = vx_mouse / speed_mouse;
-                    float mvy = vy_mouse / speed_mouse;
-
-                    // Vector from mouse position to rectangle center
-                    float to_rect_x = rect->bbox.center.x - mouse_world_x;
-                    float to_rect_y = rect->bbox.center.y - mouse_world_y;
-                    float to_rect_len = std::sqrt(to_rect_x * to_rect_x +
-                                                  to_rect_y * to_rect_y);
-
-                    if (to_rect_len > EPS)
-                    {
-                        // Normalize vector to rectangle
-                        to_rect_x /= to_rect_len;
-                        to_rect_y /= to_rect_len;
-
-                        // Calculate dot product: positive means rectangle is
-                        // "in front" of mouse movement
-                        float dot_product = mvx * to_rect_x + mvy * to_rect_y;
-
-                        // Only apply force if rectangle is in front
-                        // (dot_product > 0) Use the dot product as a multiplier
-                        // to scale force based on alignment
-                        if (dot_product > 0.0f)
-                        {
-                            float force_magnitude = speed_mouse * dt_mouse *
-                                                    penetration * MOUSE_MASS *
-                                                    dot_product;
-
-                            rect->velocity.x += mvx * force_magnitude;
-                            rect->velocity.y += mvy * force_magnitude;
-                        }
-                    }
-                }
-            }
-
-            rect->updatePhysics(dt);
-
-            bbox = rect->bbox; // returns min/max x/y (implement if
-                               // not existing)
-            if (bbox.center.y + bbox.radius > world_height)
-            {
-                rect->setVelocity(0.0f, 0.0f);
-                rect->bbox.center.y = std::clamp(bbox.center.y, bbox.radius,
-                                                 world_height - bbox.radius);
-                rect->position.y = rect->bbox.center.y;
-                rect->stop_time = current_time;
-                rect->move = false;
-                to_remove.push_back(rect);
-                // Avoid further processing on this rect in this iteration
-                continue;
-            }
-
-            if (bbox.center.x + bbox.radius < 0 ||
-                bbox.center.x - bbox.radius > world_width)
-            {
-                // Defer erase until after loop to keep indices stable
-                to_remove_active_only.push_back(rect);
-                continue;
-            }
-        }
-
-        // Move selected rectangles from active -> settled by pointer
-        if (!to_remove.empty())
-        {
-            for (auto *r : to_remove)
-            {
-                settledRects.push_back(r);
-            }
-            for (auto *r : to_remove)
-            {
-                auto it =
-                    std::remove(activeRects.begin(), activeRects.end(), r);
-                if (it != activeRects.end())
-                    activeRects.erase(it, activeRects.end());
-            }
-            to_remove.clear();
-        }
-
-        // Remove any active-only indices (objects that left horizontal bounds)
-        if (!to_remove_active_only.empty())
-        {
-            for (auto *r : to_remove_active_only)
-            {
-                auto it =
-                    std::remove(activeRects.begin(), activeRects.end(), r);
-                if (it != activeRects.end())
-                    activeRects.erase(it, activeRects.end());
-            }
-            to_remove_active_only.clear();
-        }
+        // The next frame is simulated on the simulation thread (fixed steps,
+        // however long the frame took) while this one draws the newest
+        // finished frame
+        request_simulation_frame();
 
         // Render the frame
-        render_frame(fps);
+        render_frame(fps, latest_snapshot());
         // Swap front and back buffers
         glfwSwapBuffers(window);
     }
 
     std::cout << "Shutting down..." << std::endl;
+    stop_simulation_thread();
 
     // Custom
     // cleanup
@@ -0,0 +1,148 @@
+#include "rendering/instance_ring.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+InstanceRing::~InstanceRing() { destroy(); }
+
+bool InstanceRing::create(size_t stride, size_t capacity, size_t max_capacity)
+{
+    destroy();
+    if (!GLAD_GL_VERSION_4_4)
+    {
+        std::cerr << "Instance ring needs OpenGL 4.4 (ARB_buffer_storage)"
+                  << std::endl;
+        return false;
+    }
+
+    _stride = stride;
+    _max_capacity = std::max<size_t>(max_capacity, 1);
+    return _allocate(std::clamp<size_t>(capacity, 1, _max_capacity));
+}
+
+void InstanceRing::destroy()
+{
+    for (GLsync &fence : _fences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (_buffer != 0)
+    {
+        // Deleting a mapped buffer unmaps it
+        glDeleteBuffers(1, &_buffer);
+        _buffer = 0;
+    }
+    _mapped = nullptr;
+    _capacity = 0;
+    _used = 0;
+}
+
+bool InstanceRing::_allocate(size_t capacity)
+{
+    constexpr GLbitfield FLAGS =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLsizeiptr size =
+        static_cast<GLsizeiptr>(capacity * _stride * RING_REGIONS);
+
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, FLAGS);
+    void *mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, FLAGS);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (!mapped)
+    {
+        std::cerr << "Failed to map " << size << " bytes of instance ring"
+                  << std::endl;
+        glDeleteBuffers(1, &buffer);
+        return false;
+    }
+
+    // Draws still queued on the old buffer keep it alive; its fences guard
+    // memory that is no longer written
+    const int region = _region;
+    destroy();
+    _buffer = buffer;
+    _mapped = static_cast<unsigned char *>(mapped);
+    _capacity = capacity;
+    _region = region;
+    return true;
+}
+
+void InstanceRing::_waitRegion(int region)
+{
+    GLsync &fence = _fences[region];
+    if (!fence)
+        return;
+
+    // Poll first; only a real wait flushes, so the fence reaches the GPU
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        constexpr GLuint64 WAIT_NS = 1000000000; // 1 s per attempt
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        do
+        {
+            status = glClientWaitSync(fence, flags, WAIT_NS);
+            flags = 0;
+        } while (status == GL_TIMEOUT_EXPIRED);
+
+        ++_stalls;
+        _stall_seconds += std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void InstanceRing::beginFrame()
+{
+    _region = (_region + 1) % RING_REGIONS;
+    _used = 0;
+    _waitRegion(_region);
+}
+
+InstanceRing::Span InstanceRing::allocate(size_t count)
+{
+    if (!_mapped || count == 0)
+        return {};
+
+    if (_used + count > _capacity && _capacity < _max_capacity)
+    {
+        // Grow to the next power of two that fits the frame so far; what was
+        // already written this frame stays in the old buffer for its draws
+        size_t capacity = _capacity;
+        while (capacity < _used + count && capacity < _max_capacity)
+            capacity *= 2;
+        _allocate(std::min(capacity, _max_capacity));
+    }
+
+    count = std::min(count, _capacity - std::min(_used, _capacity));
+    if (count == 0)
+        return {};
+
+    const size_t first = static_cast<size_t>(_region) * _capacity + _used;
+    _used += count;
+
+    Span span;
+    span.data = _mapped + first * _stride;
+    span.offset = static_cast<GLintptr>(first * _stride);
+    span.count = count;
+    return span;
+}
+
+void InstanceRing::endFrame()
+{
+    if (!_buffer)
+        return;
+    if (_fences[_region])
+        glDeleteSync(_fences[_region]);
+    _fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -1,11 +1,16 @@
 
 #include "rendering/rasterize.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <string>
 
+#include "entities/particles.h"
 #include "rendering/fragment_shader.h"
+#include "rendering/instance_format.h"
+#include "rendering/instance_ring.h"
 #include "rendering/vertex_shader.h"
+#include "utils/trig_table.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -115,10 +120,25 @@ static unsigned int VAO = 0;
 static unsigned int VBO = 0;
 
 // Global variables for instanced rendering
-static GLuint instanceVBO = 0;
 static GLuint instanceVAO = 0;
+static GLuint geometryVBO = 0;
 static const int MAX_INSTANCES = 1000000; // Support up to 500k rectangles
 
+// Per-frame instance data, written straight into mapped GPU memory. Starts
+// at a region of 64k instances and grows to MAX_INSTANCES as needed.
+static InstanceRing instance_ring;
+static const size_t RING_INITIAL_INSTANCES = 1 << 16;
+
+// Vertex buffer binding the instance attributes read from
+static const GLuint INSTANCE_BINDING = 1;
+
+// Retained instances of the settled confetti, one slot per archive record
+// (see SimSnapshot::settled_ranges); dead records have zero size
+static GLuint settledVBO = 0;
+static size_t settled_capacity = 0; // slots the buffer holds
+static u32 settled_slots = 0;       // slots in use
+static u64 settled_frame = 0;       // snapshot whose changes were applied last
+
 // GPU trig table
 static GLuint trigTableTexture = 0;
 static float trigTableSize = 0.0f;
@@ -134,6 +154,9 @@ static GLint uWorldScaleLoc =
 static GLint uWorldOffsetLoc =
     -1; // NEW: for GPU-side world coordinate conversion
 static GLint uVelocityChange = -1; // NEW: for GPU-side velocity change
+static GLint uAnalyticMotionLoc = -1; // closed-form flights in the shader
+static GLint uPosOriginLoc = -1;      // instance position decoding
+static GLint uPosStepLoc = -1;
 
 // Cached window dimensions for performance
 static int cached_width = 800;
@@ -170,24 +193,16 @@ static unsigned int compileShader(unsigned int type, const char *source)
 // Function to upload trig table to GPU as a 1D texture
 static bool uploadTrigTableToGPU()
 {
-    if (trig_table.empty())
-    {
-        std::cerr << "Error: Trig table is empty. Make sure to call "
-                     "precompute_trig_table() first."
-                  << std::endl;
-        return false;
-    }
-
     // Store the table size for shader
-    trigTableSize = static_cast<float>(trig_table_size);
+    trigTableSize = static_cast<float>(TRIG_TABLE_SIZE);
 
     // Prepare texture data (interleaved sin, cos values for RG format)
     std::vector<float> textureData;
-    textureData.reserve(trig_table.size() * 2);
-    for (const auto &entry : trig_table)
+    textureData.reserve(TRIG_TABLE_SIZE * 2);
+    for (u32 i = 0; i < TRIG_TABLE_SIZE; ++i)
     {
-        textureData.push_back(entry.first);  // sin value (R channel)
-        textureData.push_back(entry.second); // cos value (G channel)
+        textureData.push_back(trig_table.sin[i]); // sin value (R channel)
+        textureData.push_back(trig_table.cos[i]); // cos value (G channel)
     }
 
     // Create and upload the texture
@@ -195,19 +210,20 @@ static bool uploadTrigTableToGPU()
     glBindTexture(GL_TEXTURE_1D, trigTableTexture);
 
     // Upload data as RG32F texture (Red = sin, Green = cos)
-    // The width should be trig_table.size(), not trig_table.size() * 2
-    glTexImage1D(GL_TEXTURE_1D, 0, GL_RG32F, trig_table.size(), 0, GL_RG,
+    // The width is the entry count, not the float count
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RG32F, TRIG_TABLE_SIZE, 0, GL_RG,
                  GL_FLOAT, textureData.data());
 
     // Set texture parameters
     glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER,
                     GL_NEAREST); // No interpolation for lookup table
     glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    // The table covers exactly one turn, so repeating wraps any angle
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 
     glBindTexture(GL_TEXTURE_1D, 0);
 
-    std::cout << "Uploaded trig table to GPU with " << trig_table.size()
+    std::cout << "Uploaded trig table to GPU with " << TRIG_TABLE_SIZE
               << " entries" << std::endl;
     return true;
 }
@@ -295,6 +311,9 @@ bool rasterize_init()
         glGetUniformLocation(shaderProgram, "uWorldOffset"); // NEW
     uVelocityChange =
         glGetUniformLocation(shaderProgram, "uVelocityChange"); // NEW
+    uAnalyticMotionLoc = glGetUniformLocation(shaderProgram, "uAnalyticMotion");
+    uPosOriginLoc = glGetUniformLocation(shaderProgram, "uPosOrigin");
+    uPosStepLoc = glGetUniformLocation(shaderProgram, "uPosStep");
 
     std::cout << "Rasterizer initialized successfully" << std::endl;
     return true;
@@ -323,10 +342,19 @@ void rasterize_cleanup()
         batchShaderProgram = 0;
     }
     // Clean up instanced rendering resources
-    if (instanceVBO != 0)
+    instance_ring.destroy();
+    if (settledVBO != 0)
+    {
+        glDeleteBuffers(1, &settledVBO);
+        settledVBO = 0;
+    }
+    settled_capacity = 0;
+    settled_slots = 0;
+    settled_frame = 0;
+    if (geometryVBO != 0)
     {
-        glDeleteBuffers(1, &instanceVBO);
-        instanceVBO = 0;
+        glDeleteBuffers(1, &geometryVBO);
+        geometryVBO = 0;
     }
     if (instanceVAO != 0)
     {
@@ -379,21 +407,13 @@ void end_batch_render()
     glBindVertexArray(0);
 }
 
-int _buffer_size = 18;
-
-void instanced_draw_rectangles(const std::vector<obj::Rectangle *> &rectangles,
-                               bool isBackground = false)
+// Initialize instanced rendering resources on first use
+static void init_instanced_rendering()
 {
-    if (rectangles.empty())
-        return;
-
-    // Initialize instanced rendering resources if needed
     static bool instanced_initialized = false;
     if (!instanced_initialized)
     {
 
-        // Create instance data buffer
-        glGenBuffers(1, &instanceVBO);
         glGenVertexArrays(1, &instanceVAO);
 
         // Set up the base rectangle geometry (unit square)
@@ -412,7 +432,6 @@ void instanced_draw_rectangles(const std::vector<obj::Rectangle *> &rectangles,
         glBindVertexArray(instanceVAO);
 
         // Upload base geometry
-        GLuint geometryVBO;
         glGenBuffers(1, &geometryVBO);
         glBindBuffer(GL_ARRAY_BUFFER, geometryVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(base_vertices), base_vertices,
@@ -423,77 +442,54 @@ void instanced_draw_rectangles(const std::vector<obj::Rectangle *> &rectangles,
                               (void *)0);
         glEnableVertexAttribArray(0);
 
-        // Set up instance data buffer (empty for now, will be filled each
-        // frame)
-        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-        glBufferData(GL_ARRAY_BUFFER,
-                     MAX_INSTANCES * _buffer_size * sizeof(float), nullptr,
-                     GL_DYNAMIC_DRAW);
-
-        // Instance attributes: position(2) + size(2) + color(4) + angles(3) +
-        // velocity(2) + spawn_time(1) + flags(2) = 16 floats per instance
-        // Position offset (location 1) - now world coordinates
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE,
-                              _buffer_size * sizeof(float), (void *)0);
-        glEnableVertexAttribArray(1);
-        glVertexAttribDivisor(1, 1); // Advance once per instance
-
-        // Size (location 2) - now world coordinates
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE,
-                              _buffer_size * sizeof(float),
-                              (void *)(2 * sizeof(float)));
-        glEnableVertexAttribArray(2);
-        glVertexAttribDivisor(2, 1);
-
-        // Color (location 3)
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE,
-                              _buffer_size * sizeof(float),
-                              (void *)(4 * sizeof(float)));
-        glEnableVertexAttribArray(3);
-        glVertexAttribDivisor(3, 1);
-
-        // Rotation angles (location 4) - 3 components for pitch, yaw, roll
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE,
-                              _buffer_size * sizeof(float),
-                              (void *)(8 * sizeof(float)));
-        glEnableVertexAttribArray(4);
-        glVertexAttribDivisor(4, 1);
-
-        // Velocity (location 5) - 2 components for velocity X and Y in world
-        // units per second
-        glVertexAttribPointer(5, 2, GL_FLOAT, GL_FALSE,
-                              _buffer_size * sizeof(float),
-                              (void *)(11 * sizeof(float)));
-        glEnableVertexAttribArray(5);
-        glVertexAttribDivisor(5, 1);
-
-        // Spawn time (location 6) - 1 component for spawn time in seconds
-        glVertexAttribPointer(6, 1, GL_FLOAT, GL_FALSE,
-                              _buffer_size * sizeof(float),
-                              (void *)(13 * sizeof(float)));
-        glEnableVertexAttribArray(6);
-        glVertexAttribDivisor(6, 1);
-
-        // Spawn time (location 6) - 1 component for spawn time in seconds
-        glVertexAttribPointer(7, 1, GL_FLOAT, GL_FALSE,
-                              _buffer_size * sizeof(float),
-                              (void *)(14 * sizeof(float)));
-        glEnableVertexAttribArray(7);
-        glVertexAttribDivisor(7, 1);
-
-        // Flags (location 7) - 2 components for should_rotate and move flags
-        glVertexAttribPointer(8, 2, GL_FLOAT, GL_FALSE,
-                              _buffer_size * sizeof(float),
-                              (void *)(15 * sizeof(float)));
+        // Instance data lives in the ring and is filled each frame. The
+        // attributes only describe the layout; draw_instances() binds the
+        // ring at each draw's offset.
+        const GLsizei stride = sizeof(PackedInstance);
+        if (!instance_ring.create(stride, RING_INITIAL_INSTANCES,
+                                  MAX_INSTANCES))
+            std::cerr << "Failed to create instance ring" << std::endl;
+
+        // Instance attributes in the packed layout of PackedInstance, all
+        // advancing once per instance
+        const auto instance_attribute =
+            [](GLuint location, GLint components, GLenum type,
+               GLboolean normalized, size_t offset)
+        {
+            glVertexAttribFormat(location, components, type, normalized,
+                                 static_cast<GLuint>(offset));
+            glVertexAttribBinding(location, INSTANCE_BINDING);
+            glEnableVertexAttribArray(location);
+        };
+        glVertexBindingDivisor(INSTANCE_BINDING, 1);
+
+        // Position (location 1) - fixed-point steps, decoded by the shader
+        instance_attribute(1, 2, GL_UNSIGNED_SHORT, GL_FALSE,
+                           offsetof(PackedInstance, x));
+        // Size (location 2) - world coordinates
+        instance_attribute(2, 2, GL_HALF_FLOAT, GL_FALSE,
+                           offsetof(PackedInstance, width));
+        // Color (location 3) - RGBA8 read as [0, 1]
+        instance_attribute(3, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                           offsetof(PackedInstance, color));
+        // Rotation angles (location 4) - pitch, yaw, roll in turn steps
+        instance_attribute(4, 3, GL_UNSIGNED_SHORT, GL_FALSE,
+                           offsetof(PackedInstance, pitch));
+        // Velocity (location 5) - world units per second
+        instance_attribute(5, 2, GL_HALF_FLOAT, GL_FALSE,
+                           offsetof(PackedInstance, vel_x));
+        // Drag (location 6) - k in 1/s
+        instance_attribute(6, 1, GL_HALF_FLOAT, GL_FALSE,
+                           offsetof(PackedInstance, k));
+        // Launch (location 7) - time of position/velocity from the epoch
+        instance_attribute(7, 1, GL_FLOAT, GL_FALSE,
+                           offsetof(PackedInstance, time));
+
+        // Flags (location 8) - INSTANCE_* bits, read as an integer
+        glVertexAttribIFormat(8, 1, GL_UNSIGNED_SHORT,
+                              offsetof(PackedInstance, flags));
+        glVertexAttribBinding(8, INSTANCE_BINDING);
         glEnableVertexAttribArray(8);
-        glVertexAttribDivisor(8, 1);
-
-        // Spawn time (location 6) - 1 component for spawn time in seconds
-        glVertexAttribPointer(9, 1, GL_FLOAT, GL_FALSE,
-                              _buffer_size * sizeof(float),
-                              (void *)(17 * sizeof(float)));
-        glEnableVertexAttribArray(9);
-        glVertexAttribDivisor(9, 1);
 
         // Persistent OpenGL state setup for better performance (NEW
         // OPTIMIZATION)
@@ -506,70 +502,116 @@ void instanced_draw_rectangles(const std::vector<obj::Rectangle *> &rectangles,
         std::cout << "Instanced rendering initialized with support for "
                   << MAX_INSTANCES << " rectangles" << std::endl;
     }
+}
 
-    // Prepare instance data - use static vector to avoid allocations
-    // (OPTIMIZED)
-    static std::vector<float> instance_data;
-    instance_data.resize(
-        rectangles.size() *
-        _buffer_size); // 16 floats per instance now (added flags)
+// Snapshot of the frame being drawn, see begin_instanced_frame()
+static const SimSnapshot *render_snapshot = nullptr;
 
-    size_t data_index = 0;
-    for (const auto *rect : rectangles)
+// Epoch of the instance times this frame, see instance_epoch()
+static double render_epoch = 0.0;
+
+// Make room for `slots` settled instances, keeping the first `keep`
+static void reserve_settled(size_t slots, size_t keep)
+{
+    if (slots <= settled_capacity)
+        return;
+
+    size_t capacity = std::max<size_t>(settled_capacity, 4096);
+    while (capacity < slots)
+        capacity *= 2;
+
+    const GLsizeiptr stride = static_cast<GLsizeiptr>(instance_ring.stride());
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, capacity * stride, nullptr,
+                 GL_DYNAMIC_COPY);
+    if (settledVBO != 0)
     {
-        if (!rect || !rect->should_render)
-            continue;
-        // Send world coordinates to GPU (GPU will convert to screen
-        // coordinates)
-        float x = rect->bbox.center.x;
-        float y = rect->bbox.center.y;
-        float w = rect->width;
-        float h = rect->height;
-
-        // Convert color to float [0,1]
-        Color<float> glColor = rect->color.toGL();
-
-        // Get velocity from the rectangle's move_offset (which contains
-        // velocity * speed)
-
-        // Direct array access instead of insert() for better performance
-        instance_data[data_index++] = x;         // Initial world position X
-        instance_data[data_index++] = y;         // Initial world position Y
-        instance_data[data_index++] = w;         // World width
-        instance_data[data_index++] = h;         // World height
-        instance_data[data_index++] = glColor.r; // Color R
-        instance_data[data_index++] = glColor.g; // Color G
-        instance_data[data_index++] = glColor.b; // Color B
-        instance_data[data_index++] = glColor.a; // Color A
-        instance_data[data_index++] =
-            rect->initial_pitch;                          // Initial pitch angle
-        instance_data[data_index++] = rect->initial_yaw;  // Initial yaw angle
-        instance_data[data_index++] = rect->initial_roll; // Initial roll angle
-        instance_data[data_index++] =
-            rect->velocity.x; // Velocity X (world units per second)
-        instance_data[data_index++] =
-            rect->velocity.y; // Velocity Y (world units per second)
-        instance_data[data_index++] = rect->spawn_time; // Spawn time (seconds)
-        instance_data[data_index++] = rect->stop_time;  // Spawn time (seconds)
-        instance_data[data_index++] =
-            rect->should_rotate ? 1.0f : 0.0f; // Should rotate flag
-        instance_data[data_index++] = rect->move ? 1.0f : 0.0f; // Move flag
-        instance_data[data_index++] =
-            isBackground ? 1.0f : 0.0f; // Is background flag
+        if (keep > 0)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, settledVBO);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0,
+                                0, keep * stride);
+        }
+        glDeleteBuffers(1, &settledVBO);
     }
+    settledVBO = buffer;
+    settled_capacity = capacity;
+}
 
-    if (instance_data.empty())
+// Bring the retained settled instances up to date with `frame`. Changed
+// records are packed into the instance ring and copied into place on the
+// GPU, so neither side waits for draws still reading the retained buffer.
+static void update_settled(const SimSnapshot &frame)
+{
+    if (frame.frame == settled_frame || instance_ring.buffer() == 0)
         return;
+    settled_frame = frame.frame;
 
-    // Upload instance data
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, instance_data.size() * sizeof(float),
-                    instance_data.data());
+    reserve_settled(frame.settled_slots,
+                    frame.settled_rebuild ? 0 : settled_slots);
+    settled_slots = frame.settled_slots;
+    if (frame.settled_ranges.empty())
+        return;
 
-    // Minimal state changes - OpenGL state is persistent from initialization
-    // (OPTIMIZED)
+    const GLintptr stride = static_cast<GLintptr>(instance_ring.stride());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, settledVBO);
+
+    const obj::SettledRecord *record = frame.settled_changes.data();
+    for (const obj::RecordRange &range : frame.settled_ranges)
+    {
+        u32 first = range.first;
+        while (first < range.end)
+        {
+            const InstanceRing::Span span =
+                instance_ring.allocate(range.end - first);
+            if (span.count == 0)
+            {
+                // This frame's region is full: move on to the next one
+                instance_ring.endFrame();
+                instance_ring.beginFrame();
+                continue;
+            }
+
+            PackedInstance *out = static_cast<PackedInstance *>(span.data);
+            for (size_t n = 0; n < span.count; ++n)
+                out[n] = pack_settled(*record++);
+
+            // Allocating may have grown the ring into a new buffer
+            glBindBuffer(GL_COPY_READ_BUFFER, instance_ring.buffer());
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                span.offset, first * stride,
+                                span.count * stride);
+            first += static_cast<u32>(span.count);
+        }
+    }
+}
+
+void begin_instanced_frame(const SimSnapshot &frame)
+{
+    init_instanced_rendering();
+    render_snapshot = &frame;
+    render_epoch = instance_epoch(frame.render_time);
+
+    // Waits only if the GPU still reads what was drawn three frames ago
+    instance_ring.beginFrame();
+    update_settled(frame);
+}
+
+void end_instanced_frame() { instance_ring.endFrame(); }
+
+// Issue the instanced draw call for `count` instances at `offset` bytes
+// into `buffer`
+static void draw_instances(GLuint buffer, GLintptr offset, size_t count)
+{
+    // Read this draw's instances where they were written
     glBindVertexArray(instanceVAO);
+    glBindVertexBuffer(INSTANCE_BINDING, buffer, offset,
+                       static_cast<GLsizei>(instance_ring.stride()));
 
+    // Minimal state changes - OpenGL state is persistent from initialization
+    // (OPTIMIZED)
     // Set uniforms using cached locations (PERFORMANCE OPTIMIZATION)
     glUniform1i(uTrigTableLoc, 0); // Texture unit 0
     glUniform1f(uTrigTableSizeLoc, trigTableSize);
@@ -579,20 +621,111 @@ void instanced_draw_rectangles(const std::vector<obj::Rectangle *> &rectangles,
     // NEW: Pass world coordinate system parameters to GPU
     glUniform1f(uWorldScaleLoc, world_scale);
     glUniform2f(uWorldOffsetLoc, world_offset_x, world_offset_y);
-
-    glUniform1f(uVelocityChange, GRAVITY_ACCELERATION);
-
-    // NEW: Pass time and rotation speed to GPU for angle calculation
-    glUniform1f(uTimeLoc, static_cast<float>(glfwGetTime()));
+    glUniform1f(uPosOriginLoc, INSTANCE_POS_ORIGIN);
+    glUniform1f(uPosStepLoc, INSTANCE_POS_STEP);
+
+    const SimSnapshot &frame = *render_snapshot;
+    glUniform1f(uVelocityChange, frame.gravity);
+    glUniform1f(uAnalyticMotionLoc, frame.analytic ? 1.0f : 0.0f);
+
+    // NEW: Pass time and rotation speed to GPU for angle calculation. Same
+    // clock as the particle state times, between the last two fixed steps,
+    // and like them counted from the epoch.
+    glUniform1f(uTimeLoc,
+                static_cast<float>(frame.render_time - render_epoch));
     glUniform1f(uRotationSpeedLoc, ROTATION_SPEED);
 
     glDrawArraysInstanced(
         GL_TRIANGLES, 0, 6,
-        rectangles.size()); // 6 vertices per rectangle, N instances
+        static_cast<GLsizei>(count)); // 6 vertices per rectangle
 
     glBindVertexArray(0);
 }
 
+void instanced_draw_rectangles(const std::vector<obj::Rectangle *> &rectangles,
+                               bool isBackground = false)
+{
+    if (rectangles.empty())
+        return;
+
+    // Pack straight into this frame's region of the instance ring
+    const InstanceRing::Span span = instance_ring.allocate(rectangles.size());
+    if (span.count == 0)
+        return;
+    PackedInstance *instance_data =
+        static_cast<PackedInstance *>(span.data);
+
+    // Rectangles are drawn where they are, so their state is "now"
+    const float state_time =
+        static_cast<float>(render_snapshot->render_time - render_epoch);
+
+    size_t packed = 0;
+    for (const auto *rect : rectangles)
+    {
+        if (packed == span.count)
+            break;
+        if (!rect || !rect->should_render)
+            continue;
+
+        // Send world coordinates to GPU (GPU will convert to screen
+        // coordinates)
+        PackedInstance &out = instance_data[packed++];
+        out.x = pack_instance_pos(rect->bbox.center.x); // World position X
+        out.y = pack_instance_pos(rect->bbox.center.y); // World position Y
+        out.width = pack_half(rect->width);             // World width
+        out.height = pack_half(rect->height);           // World height
+        out.color = pack_rgba8(rect->color.r, rect->color.g, rect->color.b,
+                               rect->color.a); // Color, RGBA8
+
+        // Initial angles plus the spin so far, see epoch_turn()
+        const u16 turn = epoch_turn(ROTATION_SPEED, render_epoch,
+                                    rect->spawn_time, rect->stop_time);
+        out.pitch = static_cast<u16>(pack_angle(rect->initial_pitch) + turn);
+        out.yaw = static_cast<u16>(pack_angle(rect->initial_yaw) + turn);
+        out.roll = static_cast<u16>(pack_angle(rect->initial_roll) + turn);
+
+        out.k = 0;                               // Drag (unused)
+        out.vel_x = pack_half(rect->velocity.x); // Velocity X
+        out.vel_y = pack_half(rect->velocity.y); // Velocity Y
+        out.time = state_time;                   // State time
+        out.flags = (rect->should_rotate ? INSTANCE_ROTATE : 0) |
+                    (rect->stop_time > 0.0f ? 0 : INSTANCE_SPIN) |
+                    (rect->move ? INSTANCE_MOVE : 0) |
+                    (isBackground ? INSTANCE_BACKGROUND : 0);
+        out.unused = 0;
+    }
+
+    if (packed == 0)
+        return;
+
+    // Hidden rectangles leave the tail of the span unused
+    draw_instances(instance_ring.buffer(), span.offset, packed);
+}
+
+void instanced_draw_particles(const SimSnapshot &frame)
+{
+    // Settled pieces first, with one draw from their retained buffer; it
+    // was brought up to date by begin_instanced_frame()
+    if (settled_slots > 0)
+        draw_instances(settledVBO, 0, settled_slots);
+
+    if (frame.flying() == 0)
+        return;
+
+    // Pieces in flight or fading, read from the snapshot's arrays. The ring
+    // caps a frame at MAX_INSTANCES.
+    const InstanceRing::Span span = instance_ring.allocate(frame.flying());
+    const size_t count = span.count;
+    if (count == 0)
+        return;
+
+    PackedInstance *out = static_cast<PackedInstance *>(span.data);
+    for (size_t n = 0; n < count; ++n)
+        pack_flying(frame, n, render_epoch, out[n]);
+
+    draw_instances(instance_ring.buffer(), span.offset, count);
+}
+
 // ############# DEPRECATED #############
 
 void draw_center_dots(const std::vector<obj::Rectangle *> &rectangles)
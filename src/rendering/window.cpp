@@ -132,7 +132,7 @@ std::pair<bool, GLFWwindow *> window_init()
     return {true, window};
 }
 
-void render_frame(float &fps)
+void render_frame(float &fps, const SimSnapshot &frame)
 {
     // Clear the screen with transparent/black (the world background rectangle
     // will handle the black)
@@ -143,6 +143,9 @@ void render_frame(float &fps)
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
+    // Clock and physics parameters of the instances come from the snapshot
+    begin_instanced_frame(frame);
+
     // INSTANCED RENDERING OPTIMIZATION: Draw all rectangles with maximum
     // efficiency
     for (size_t i = 0; i < render_order.size(); ++i)
@@ -157,6 +160,11 @@ void render_frame(float &fps)
             // draw_center_dots(layer);
         }
 
+        if (i == layer_rectangles)
+        {
+            instanced_draw_particles(frame);
+        }
+
         if (i == layer_text)
         {
             // Render title text with custom font
@@ -215,6 +223,7 @@ void render_frame(float &fps)
             }
         }
     }
+    end_instanced_frame();
 
     // Conditional ImGui rendering for better performance (NEW OPTIMIZATION)
     static bool show_ui = true; // Toggle with 'U' key or similar
@@ -229,7 +238,10 @@ void render_frame(float &fps)
         ImGui::Text("FPS: %.1f", fps);
         ImGui::Text("Frame Time: %.3f ms", 1000.0f / fps);
         ImGui::Text("VSync: %s", enable_vsync ? "ON" : "OFF");
-        ImGui::Text("Rectangle Count: %lld", activeRects.size());
+        ImGui::Text("Rectangle Count: %zu", frame.active);
+        ImGui::Text("Particles: %zu / %zu",
+                    frame.active + frame.settled, frame.budget);
+        ImGui::Text("Simulation: %.3f ms", frame.sim_seconds * 1000.0f);
         ImGui::Separator();
         ImGui::Text("Title Position: (%d, %d)", title_position_x,
                     title_position_y);
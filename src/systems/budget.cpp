@@ -0,0 +1,120 @@
+#include "systems/simulation.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "entities/particles.h"
+#include "utils/globals.h"
+
+// ########## PARTICLE BUDGET ##########
+
+static size_t budget_limit = PARTICLE_BUDGET;
+static float fade_seconds = EVICTION_FADE;
+
+void set_particle_budget(size_t max_particles)
+{
+    budget_limit = max_particles;
+}
+
+size_t particle_budget()
+{
+    const size_t capacity = particles.capacity();
+    if (budget_limit == 0)
+        return capacity ? capacity : SIZE_MAX;
+    return capacity ? std::min(budget_limit, capacity) : budget_limit;
+}
+
+void set_eviction_fade(float seconds) { fade_seconds = std::max(0.0f, seconds); }
+
+float eviction_fade() { return fade_seconds; }
+
+// Free slots plus slots the pool can still grow into
+static size_t pool_room()
+{
+    const size_t capacity = particles.capacity();
+    if (capacity == 0)
+        return SIZE_MAX;
+    return particles.free_slots.size() + (capacity - particles.size());
+}
+
+// Evict a settled piece: fade it out in place or drop it at once
+static void evict_settled(u32 id, double current_time)
+{
+    if (fade_seconds <= 0.0f)
+    {
+        particles.settled.remove(id);
+        return;
+    }
+
+    // Back into a slot for the fade; spawn_time marks the fade start
+    particles.fadeSettled(id, static_cast<float>(current_time));
+}
+
+size_t reserve_particles(size_t count, double current_time)
+{
+    const size_t budget = particle_budget();
+    count = std::min(count, budget);
+
+    // ---------- budget: oldest settled first ----------
+    size_t counted = particles.active.size() + particles.settled.size();
+    while (counted + count > budget)
+    {
+        const u32 oldest = particles.settled.oldest();
+        if (oldest == obj::NO_RECORD)
+            break;
+        evict_settled(oldest, current_time);
+        --counted;
+    }
+
+    // ---------- budget: then the longest airborne ----------
+    if (counted + count > budget)
+    {
+        static std::vector<u32> candidates;
+        const size_t excess = counted + count - budget;
+        const float *spawn_time = particles.spawn_time.data();
+
+        candidates.assign(particles.active.begin(), particles.active.end());
+        std::nth_element(candidates.begin(), candidates.begin() + (excess - 1),
+                         candidates.end(), [spawn_time](u32 a, u32 b)
+                         { return spawn_time[a] < spawn_time[b]; });
+
+        // Airborne pieces are dropped without a fade
+        for (size_t n = 0; n < excess; ++n)
+            particles.release(candidates[n]);
+    }
+
+    // ---------- pool: cut fades short when slots run out ----------
+    size_t room = pool_room();
+    while (room < count && !particles.fading.empty())
+    {
+        particles.release(particles.fading.back());
+        ++room;
+    }
+
+    return std::min(count, room);
+}
+
+void update_fading_particles(double current_time)
+{
+    std::vector<u32> &fading = particles.fading;
+    const float now = static_cast<float>(current_time);
+    const float inv_fade = fade_seconds > 0.0f ? 1.0f / fade_seconds : 0.0f;
+
+    // Walk backwards, release() swaps the last entry into the slot
+    for (size_t n = fading.size(); n-- > 0;)
+    {
+        const u32 i = fading[n];
+        const float t = (now - particles.spawn_time[i]) * inv_fade;
+        if (fade_seconds <= 0.0f || t >= 1.0f)
+        {
+            particles.release(i);
+            continue;
+        }
+
+        const u32 rgba = particles.color[i];
+        const u8 alpha = static_cast<u8>(255.0f * (1.0f - t));
+        particles.color[i] = pack_rgba8(unpack_r(rgba), unpack_g(rgba),
+                                        unpack_b(rgba), alpha);
+    }
+}
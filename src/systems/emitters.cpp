@@ -0,0 +1,288 @@
+#include "systems/emitters.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "systems/simulation.h"
+#include "utils/globals.h"
+
+// ########## EMITTER SCHEDULING ##########
+
+// A stalled frame may owe at most this many seconds of emission; anything
+// older is dropped so a hitch does not turn into a spawn spike
+static constexpr double MAX_BACKLOG = 0.25;
+
+static constexpr float DEG_TO_RAD = TWO_PI / 360.0f;
+
+struct Emitter
+{
+    u32 id;
+    EmitterConfig config;
+    bool started = false;   // next_time is valid
+    double next_time = 0.0; // emission time of the next piece
+};
+
+static std::vector<Emitter> emitters;
+static u32 next_emitter_id = 1;
+
+// Where cursor emitters spawn, see set_emitter_cursor()
+static float cursor_x = 0.0f;
+static float cursor_y = 0.0f;
+
+static Emitter *find_emitter(u32 id)
+{
+    for (Emitter &emitter : emitters)
+    {
+        if (emitter.id == id)
+            return &emitter;
+    }
+    return nullptr;
+}
+
+u32 add_emitter(const EmitterConfig &config)
+{
+    Emitter emitter;
+    emitter.id = next_emitter_id++;
+    emitter.config = config;
+    emitters.push_back(emitter);
+    return emitter.id;
+}
+
+bool remove_emitter(u32 id)
+{
+    for (size_t n = 0; n < emitters.size(); ++n)
+    {
+        if (emitters[n].id == id)
+        {
+            emitters.erase(emitters.begin() + n);
+            return true;
+        }
+    }
+    return false;
+}
+
+void clear_emitters() { emitters.clear(); }
+
+size_t emitter_count() { return emitters.size(); }
+
+void set_emitter_cursor(float x, float y)
+{
+    cursor_x = x;
+    cursor_y = y;
+}
+
+void set_emitter_enabled(u32 id, bool enabled)
+{
+    Emitter *emitter = find_emitter(id);
+    if (!emitter || emitter->config.enabled == enabled)
+        return;
+
+    emitter->config.enabled = enabled;
+    emitter->started = false;
+}
+
+// Launch parameters of an emitter at this moment
+static SpawnParams spawn_params(const EmitterConfig &config)
+{
+    SpawnParams params;
+    params.x0 = config.x0;
+    params.y0 = config.y0;
+    params.x1 = config.x1;
+    params.y1 = config.y1;
+
+    switch (config.shape)
+    {
+    case EmitterShape::Point:
+        params.shape = SpawnParams::Shape::Point;
+        break;
+    case EmitterShape::Line:
+        params.shape = SpawnParams::Shape::Line;
+        break;
+    case EmitterShape::Area:
+        params.shape = SpawnParams::Shape::Area;
+        break;
+    case EmitterShape::Cursor:
+        params.shape = SpawnParams::Shape::Point;
+        params.x0 = cursor_x;
+        params.y0 = cursor_y;
+        break;
+    }
+
+    params.direction = config.direction;
+    params.spread = config.spread;
+    params.speed_min = config.speed_min * EXPLOSION_STRENGTH;
+    params.speed_max = config.speed_max * EXPLOSION_STRENGTH;
+    return params;
+}
+
+size_t update_emitters(double current_time)
+{
+    size_t spawned = 0;
+
+    for (Emitter &emitter : emitters)
+    {
+        const EmitterConfig &config = emitter.config;
+        if (!config.enabled || !(config.rate > 0.0f))
+            continue;
+
+        // A new or resumed emitter releases its first piece now
+        if (!emitter.started)
+        {
+            emitter.next_time = current_time;
+            emitter.started = true;
+        }
+        emitter.next_time =
+            std::max(emitter.next_time, current_time - MAX_BACKLOG);
+        if (emitter.next_time > current_time)
+            continue;
+
+        // Every piece with an emission time in [next_time, current_time]
+        const double interval = 1.0 / config.rate;
+        const size_t due = static_cast<size_t>(
+                               (current_time - emitter.next_time) /
+                               interval) +
+                           1;
+
+        SpawnParams params = spawn_params(config);
+        params.first_time = emitter.next_time;
+        params.interval = interval;
+        spawned += spawn_pieces(params, due, current_time);
+
+        // Pieces the pool had no room for are skipped, not postponed
+        emitter.next_time += static_cast<double>(due) * interval;
+    }
+
+    return spawned;
+}
+
+// ########## CONFIG ##########
+
+bool parse_emitter_config(const std::string &text, EmitterConfig &config)
+{
+    std::istringstream in(text);
+    std::string shape;
+    if (!(in >> shape))
+    {
+        std::cerr << "Emitter config: missing shape" << std::endl;
+        return false;
+    }
+
+    config = EmitterConfig();
+    if (shape == "point")
+        config.shape = EmitterShape::Point;
+    else if (shape == "line")
+        config.shape = EmitterShape::Line;
+    else if (shape == "area")
+        config.shape = EmitterShape::Area;
+    else if (shape == "cursor")
+        config.shape = EmitterShape::Cursor;
+    else
+    {
+        std::cerr << "Emitter config: unknown shape '" << shape << "'"
+                  << std::endl;
+        return false;
+    }
+
+    std::string field;
+    while (in >> field)
+    {
+        const size_t eq = field.find('=');
+        if (eq == std::string::npos)
+        {
+            std::cerr << "Emitter config: expected key=value, got '" << field
+                      << "'" << std::endl;
+            return false;
+        }
+
+        const std::string key = field.substr(0, eq);
+        const std::string value = field.substr(eq + 1);
+
+        // Values are one number, except speed which is min:max
+        float second = 0.0f;
+        char *end = nullptr;
+        const float number = std::strtof(value.c_str(), &end);
+        bool valid = end != value.c_str();
+        if (valid && key == "speed")
+        {
+            valid = *end == ':';
+            if (valid)
+            {
+                const char *rest = end + 1;
+                second = std::strtof(rest, &end);
+                valid = end != rest;
+            }
+        }
+        if (!valid || *end != '\0')
+        {
+            std::cerr << "Emitter config: bad value for '" << key << "'"
+                      << std::endl;
+            return false;
+        }
+
+        if (key == "x" || key == "x0")
+            config.x0 = number;
+        else if (key == "y" || key == "y0")
+            config.y0 = number;
+        else if (key == "x1")
+            config.x1 = number;
+        else if (key == "y1")
+            config.y1 = number;
+        else if (key == "rate")
+            config.rate = number;
+        else if (key == "dir")
+            config.direction = number * DEG_TO_RAD;
+        else if (key == "spread")
+            config.spread = number * DEG_TO_RAD;
+        else if (key == "speed")
+        {
+            config.speed_min = number;
+            config.speed_max = second;
+        }
+        else
+        {
+            std::cerr << "Emitter config: unknown key '" << key << "'"
+                      << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int load_emitters(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << "Failed to open emitter config: " << path << std::endl;
+        return -1;
+    }
+
+    // Parse everything first so a bad line leaves no half-loaded scene
+    std::vector<EmitterConfig> configs;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line))
+    {
+        ++line_number;
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+            continue;
+
+        EmitterConfig config;
+        if (!parse_emitter_config(line, config))
+        {
+            std::cerr << "  at " << path << ":" << line_number << std::endl;
+            return -1;
+        }
+        configs.push_back(config);
+    }
+
+    for (const EmitterConfig &config : configs)
+        add_emitter(config);
+    return static_cast<int>(configs.size());
+}
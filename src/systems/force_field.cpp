@@ -0,0 +1,365 @@
+#include "systems/force_field.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "entities/particles.h"
+#include "utils/globals.h"
+#include "utils/trig_table.h"
+
+// ########## FIELD LIST ##########
+
+static constexpr float DEG_TO_RAD = TWO_PI / 360.0f;
+
+// Turbulence is the curl of a potential built from a few rotated sine
+// octaves. Octave o has wavelength scale / FREQUENCY[o], is turned by
+// ORIENTATION[o] and contributes WEIGHT[o] of the field's air speed.
+static constexpr int TURBULENCE_OCTAVES = 3;
+static constexpr float TURBULENCE_FREQUENCY[TURBULENCE_OCTAVES] = {1.0f, 1.93f,
+                                                                   3.71f};
+static constexpr float TURBULENCE_ORIENTATION[TURBULENCE_OCTAVES] = {
+    0.0f, 0.93f, 2.14f};
+static constexpr float TURBULENCE_WEIGHT[TURBULENCE_OCTAVES] = {0.57f, 0.29f,
+                                                                0.14f};
+
+struct Field
+{
+    u32 id;
+    FieldConfig config;
+};
+
+static std::vector<Field> fields;
+static u32 next_field_id = 1;
+
+u32 add_force_field(const FieldConfig &config)
+{
+    fields.push_back({next_field_id, config});
+    return next_field_id++;
+}
+
+bool remove_force_field(u32 id)
+{
+    for (size_t n = 0; n < fields.size(); ++n)
+    {
+        if (fields[n].id == id)
+        {
+            fields.erase(fields.begin() + n);
+            return true;
+        }
+    }
+    return false;
+}
+
+void clear_force_fields() { fields.clear(); }
+
+size_t force_field_count() { return fields.size(); }
+
+void set_force_field_enabled(u32 id, bool enabled)
+{
+    for (Field &field : fields)
+    {
+        if (field.id == id)
+            field.config.enabled = enabled;
+    }
+}
+
+// ########## FIELD GRID ##########
+
+// Accelerations at the grid nodes, row-major; node (c, r) sits at
+// (c * cell_size, r * cell_size)
+static std::vector<float> grid_ax;
+static std::vector<float> grid_ay;
+static u32 grid_cols = 2;
+static u32 grid_rows = 2;
+static float cell_size = 16.0f;
+static float inv_cell_size = 1.0f / 16.0f;
+static bool grid_active = false;
+
+void set_force_field_cell_size(float size)
+{
+    if (size > 0.0f)
+        cell_size = size;
+}
+
+bool force_field_active() { return grid_active; }
+
+// Node range [lo, hi) within `radius` of `center` along one axis
+static void node_span(float center, float radius, u32 nodes, u32 &lo,
+                      u32 &hi)
+{
+    const float first = std::ceil((center - radius) * inv_cell_size);
+    const float last = std::floor((center + radius) * inv_cell_size);
+    lo = static_cast<u32>(std::max(first, 0.0f));
+    hi = static_cast<u32>(
+        std::clamp(last, -1.0f, static_cast<float>(nodes - 1)) + 1.0f);
+}
+
+// Add `accel(dx, dy, r)` to every node within the field's radius, with
+// (dx, dy) the offset from its center
+template <typename Accel>
+static void splat_radial(const FieldConfig &config, Accel &&accel)
+{
+    const float radius = config.radius;
+    if (!(radius > 0.0f))
+        return;
+
+    u32 c0, c1, r0, r1;
+    node_span(config.x, radius, grid_cols, c0, c1);
+    node_span(config.y, radius, grid_rows, r0, r1);
+
+    const float radius2 = radius * radius;
+    for (u32 r = r0; r < r1; ++r)
+    {
+        const float dy = static_cast<float>(r) * cell_size - config.y;
+        float *ax = grid_ax.data() + static_cast<size_t>(r) * grid_cols;
+        float *ay = grid_ay.data() + static_cast<size_t>(r) * grid_cols;
+        for (u32 c = c0; c < c1; ++c)
+        {
+            const float dx = static_cast<float>(c) * cell_size - config.x;
+            const float d2 = dx * dx + dy * dy;
+            if (d2 >= radius2)
+                continue;
+            accel(dx, dy, std::sqrt(d2), ax[c], ay[c]);
+        }
+    }
+}
+
+// Air velocity of every turbulence octave, scaled by the drag constant
+static void splat_turbulence(const Field &field, float k, double time)
+{
+    const FieldConfig &config = field.config;
+    if (!(config.scale > 0.0f))
+        return;
+
+    for (int o = 0; o < TURBULENCE_OCTAVES; ++o)
+    {
+        const float f = TURBULENCE_FREQUENCY[o] * TWO_PI / config.scale;
+        float rot_s, rot_c;
+        trig_lookup(TURBULENCE_ORIENTATION[o] + 0.37f * field.id, rot_s,
+                    rot_c);
+
+        // ψ = A sin(f u + p) sin(f v + q) in coordinates (u, v) turned by
+        // the octave's orientation; the phases drift in opposite directions
+        // so the pattern evolves instead of sliding
+        const float drift = static_cast<float>(std::fmod(
+            TWO_PI * config.rate * TURBULENCE_FREQUENCY[o] * time, TWO_PI));
+        const float p = 1.618f * field.id * (o + 1) + drift;
+        const float q = 2.718f * field.id * (o + 1) - drift;
+        const float amplitude = k * config.strength * TURBULENCE_WEIGHT[o];
+
+        for (u32 r = 0; r < grid_rows; ++r)
+        {
+            const float y = static_cast<float>(r) * cell_size;
+            float *ax = grid_ax.data() + static_cast<size_t>(r) * grid_cols;
+            float *ay = grid_ay.data() + static_cast<size_t>(r) * grid_cols;
+            for (u32 c = 0; c < grid_cols; ++c)
+            {
+                const float x = static_cast<float>(c) * cell_size;
+                const float u = rot_c * x + rot_s * y;
+                const float v = rot_c * y - rot_s * x;
+
+                float su, cu, sv, cv;
+                trig_lookup(f * u + p, su, cu);
+                trig_lookup(f * v + q, sv, cv);
+
+                // Gradient of ψ / (A f), back in world axes
+                const float du = cu * sv;
+                const float dv = su * cv;
+                const float dx = rot_c * du - rot_s * dv;
+                const float dy = rot_s * du + rot_c * dv;
+
+                // Air velocity = curl ψ = (∂ψ/∂y, -∂ψ/∂x)
+                ax[c] += amplitude * dy;
+                ay[c] -= amplitude * dx;
+            }
+        }
+    }
+}
+
+void build_force_field(double time)
+{
+    grid_active = false;
+    for (const Field &field : fields)
+        grid_active |= field.config.enabled;
+    if (!grid_active)
+        return;
+
+    inv_cell_size = 1.0f / cell_size;
+    grid_cols = std::max(
+        2u, static_cast<u32>(std::ceil(world_width * inv_cell_size)) + 1);
+    grid_rows = std::max(
+        2u, static_cast<u32>(std::ceil(world_height * inv_cell_size)) + 1);
+    const size_t nodes = static_cast<size_t>(grid_cols) * grid_rows;
+
+    // Air moves the confetti through drag, a = k * v_air
+    const float k = particles.drag;
+
+    // Every wind is uniform, so they are summed before touching the grid
+    float wind_x = 0.0f, wind_y = 0.0f;
+    for (const Field &field : fields)
+    {
+        const FieldConfig &config = field.config;
+        if (config.enabled && config.kind == FieldKind::Wind)
+        {
+            float s, c;
+            trig_lookup(config.direction, s, c);
+            wind_x += k * config.strength * c;
+            wind_y += k * config.strength * s;
+        }
+    }
+    grid_ax.assign(nodes, wind_x);
+    grid_ay.assign(nodes, wind_y);
+
+    for (const Field &field : fields)
+    {
+        const FieldConfig &config = field.config;
+        if (!config.enabled)
+            continue;
+
+        switch (config.kind)
+        {
+        case FieldKind::Wind:
+            break;
+
+        case FieldKind::Vortex:
+        {
+            // Tangential air speed 4 s (r/R)(1 - r/R): still at the center
+            // and the rim, `strength` halfway out. Divided by r it gives
+            // the factor on the perpendicular offset (-dy, dx).
+            const float scale = 4.0f * k * config.strength / config.radius;
+            const float inv_radius = 1.0f / config.radius;
+            splat_radial(config,
+                         [=](float dx, float dy, float r, float &ax, float &ay)
+                         {
+                             const float w = scale * (1.0f - r * inv_radius);
+                             ax -= w * dy;
+                             ay += w * dx;
+                         });
+            break;
+        }
+
+        case FieldKind::Attractor:
+        {
+            // Falls off linearly from `strength` at the center to 0 at R
+            const float inv_radius = 1.0f / config.radius;
+            const float strength = config.strength;
+            splat_radial(config,
+                         [=](float dx, float dy, float r, float &ax, float &ay)
+                         {
+                             if (r < 1e-3f)
+                                 return;
+                             const float w =
+                                 strength * (1.0f - r * inv_radius) / r;
+                             ax -= w * dx;
+                             ay -= w * dy;
+                         });
+            break;
+        }
+
+        case FieldKind::Turbulence:
+            splat_turbulence(field, k, time);
+            break;
+        }
+    }
+}
+
+// ########## SAMPLING ##########
+
+const ForceGrid *force_grid()
+{
+    static ForceGrid grid;
+    if (!grid_active)
+        return nullptr;
+
+    grid = {grid_ax.data(), grid_ay.data(), grid_cols, grid_rows,
+            inv_cell_size};
+    return &grid;
+}
+
+void sample_force_field(float x, float y, float &ax, float &ay)
+{
+    ax = 0.0f;
+    ay = 0.0f;
+    if (const ForceGrid *grid = force_grid())
+        sample_force_grid(*grid, x, y, ax, ay);
+}
+
+// ########## CONFIG ##########
+
+bool parse_field_config(const std::string &text, FieldConfig &config)
+{
+    std::istringstream in(text);
+    std::string kind;
+    if (!(in >> kind))
+    {
+        std::cerr << "Field config: missing kind" << std::endl;
+        return false;
+    }
+
+    config = FieldConfig();
+    if (kind == "wind")
+        config.kind = FieldKind::Wind;
+    else if (kind == "vortex")
+        config.kind = FieldKind::Vortex;
+    else if (kind == "attractor")
+        config.kind = FieldKind::Attractor;
+    else if (kind == "turbulence")
+        config.kind = FieldKind::Turbulence;
+    else
+    {
+        std::cerr << "Field config: unknown kind '" << kind << "'"
+                  << std::endl;
+        return false;
+    }
+
+    std::string entry;
+    while (in >> entry)
+    {
+        const size_t eq = entry.find('=');
+        if (eq == std::string::npos)
+        {
+            std::cerr << "Field config: expected key=value, got '" << entry
+                      << "'" << std::endl;
+            return false;
+        }
+
+        const std::string key = entry.substr(0, eq);
+        const std::string value = entry.substr(eq + 1);
+
+        char *end = nullptr;
+        const float number = std::strtof(value.c_str(), &end);
+        if (end == value.c_str() || *end != '\0')
+        {
+            std::cerr << "Field config: bad value for '" << key << "'"
+                      << std::endl;
+            return false;
+        }
+
+        if (key == "x")
+            config.x = number;
+        else if (key == "y")
+            config.y = number;
+        else if (key == "speed" || key == "strength")
+            config.strength = number;
+        else if (key == "radius")
+            config.radius = number;
+        else if (key == "dir")
+            config.direction = number * DEG_TO_RAD;
+        else if (key == "scale")
+            config.scale = number;
+        else if (key == "rate")
+            config.rate = number;
+        else
+        {
+            std::cerr << "Field config: unknown key '" << key << "'"
+                      << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
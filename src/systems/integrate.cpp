@@ -0,0 +1,286 @@
+#include "systems/integrate.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||             \
+    defined(_M_IX86)
+#define SIM_X86 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// Defined in integrate_avx2.cpp, which is built with AVX2/FMA enabled
+#ifdef SIM_X86
+void integrate_particles_avx2(const u32 *indices, size_t count, float *pos_x,
+                              float *pos_y, float *vel_x, float *vel_y,
+                              const float *k, float dt, float gravity_dv,
+                              const ForceGrid *field);
+#endif
+
+// ########## SCALAR REFERENCE ##########
+
+void integrate_particles_scalar(const u32 *indices, size_t count,
+                                float *pos_x, float *pos_y, float *vel_x,
+                                float *vel_y, const float *k, float dt,
+                                float gravity_dv, const ForceGrid *field)
+{
+    for (size_t n = 0; n < count; ++n)
+    {
+        const u32 i = indices[n];
+        const float damping = std::exp(-k[i] * dt);
+
+        float ax = 0.0f, ay = 0.0f;
+        if (field)
+            sample_force_grid(*field, pos_x[i], pos_y[i], ax, ay);
+
+        vel_x[i] = vel_x[i] * damping + ax * dt;
+        vel_y[i] = vel_y[i] * damping + gravity_dv + ay * dt;
+
+        pos_x[i] += vel_x[i] * dt;
+        pos_y[i] += vel_y[i] * dt;
+    }
+}
+
+// ########## SSE2 (4 lanes) ##########
+
+#ifdef SIM_X86
+
+// e^x for x in [-87, 88]: range reduction to r in [-ln2/2, ln2/2], degree 6
+// Taylor polynomial for e^r, then scale by 2^n through the exponent bits.
+// Max relative error ~2e-7.
+static inline __m128 exp_sse2(__m128 x)
+{
+    x = _mm_max_ps(x, _mm_set1_ps(-87.0f));
+    x = _mm_min_ps(x, _mm_set1_ps(88.0f));
+
+    // cvtps rounds to nearest under the default MXCSR mode
+    __m128i ni = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.44269504f)));
+    __m128 n = _mm_cvtepi32_ps(ni);
+
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(0.693359375f)));
+    r = _mm_sub_ps(r, _mm_mul_ps(n, _mm_set1_ps(-2.12194440e-4f)));
+
+    __m128 p = _mm_set1_ps(1.0f / 720.0f);
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.0f / 120.0f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.0f / 24.0f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.0f / 6.0f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(0.5f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.0f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.0f));
+
+    __m128i bits = _mm_slli_epi32(_mm_add_epi32(ni, _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(p, _mm_castsi128_ps(bits));
+}
+
+// Field acceleration at four positions. The index math is vectorized; SSE2
+// has no gather, so the sixteen node reads are scalar. Node indices are
+// formed in float, which is exact for grids below 2^24 nodes.
+static inline void sample_field_sse2(const ForceGrid &grid, __m128 px,
+                                     __m128 py, __m128 &ax, __m128 &ay)
+{
+    const __m128 gx = _mm_min_ps(
+        _mm_max_ps(_mm_mul_ps(px, _mm_set1_ps(grid.inv_cell)),
+                   _mm_setzero_ps()),
+        _mm_set1_ps(static_cast<float>(grid.cols - 1)));
+    const __m128 gy = _mm_min_ps(
+        _mm_max_ps(_mm_mul_ps(py, _mm_set1_ps(grid.inv_cell)),
+                   _mm_setzero_ps()),
+        _mm_set1_ps(static_cast<float>(grid.rows - 1)));
+
+    // Truncation of non-negative values, lower node one short of the last
+    const __m128 c = _mm_cvtepi32_ps(_mm_cvttps_epi32(
+        _mm_min_ps(gx, _mm_set1_ps(static_cast<float>(grid.cols - 2)))));
+    const __m128 r = _mm_cvtepi32_ps(_mm_cvttps_epi32(
+        _mm_min_ps(gy, _mm_set1_ps(static_cast<float>(grid.rows - 2)))));
+    const __m128 tx = _mm_sub_ps(gx, c);
+    const __m128 ty = _mm_sub_ps(gy, r);
+
+    alignas(16) i32 top[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(top),
+                    _mm_cvttps_epi32(_mm_add_ps(
+                        _mm_mul_ps(r, _mm_set1_ps(static_cast<float>(
+                                          grid.cols))),
+                        c)));
+
+    const u32 cols = grid.cols;
+    auto corner = [&](const float *values, u32 offset)
+    {
+        return _mm_setr_ps(values[top[0] + offset], values[top[1] + offset],
+                           values[top[2] + offset], values[top[3] + offset]);
+    };
+    auto bilinear = [&](const float *values)
+    {
+        const __m128 v00 = corner(values, 0);
+        const __m128 v01 = corner(values, 1);
+        const __m128 v10 = corner(values, cols);
+        const __m128 v11 = corner(values, cols + 1);
+        const __m128 t = _mm_add_ps(v00, _mm_mul_ps(tx, _mm_sub_ps(v01, v00)));
+        const __m128 b = _mm_add_ps(v10, _mm_mul_ps(tx, _mm_sub_ps(v11, v10)));
+        return _mm_add_ps(t, _mm_mul_ps(ty, _mm_sub_ps(b, t)));
+    };
+    ax = bilinear(grid.ax);
+    ay = bilinear(grid.ay);
+}
+
+static void integrate_particles_sse2(const u32 *indices, size_t count,
+                                     float *pos_x, float *pos_y, float *vel_x,
+                                     float *vel_y, const float *k, float dt,
+                                     float gravity_dv, const ForceGrid *field)
+{
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 vneg_dt = _mm_set1_ps(-dt);
+    const __m128 vgravity = _mm_set1_ps(gravity_dv);
+
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4)
+    {
+        const u32 *idx = indices + n;
+        const bool contiguous = idx[3] - idx[0] == 3 &&
+                                idx[1] == idx[0] + 1 && idx[2] == idx[0] + 2;
+
+        __m128 vx, vy, px, py, kk;
+        if (contiguous)
+        {
+            const u32 i = idx[0];
+            vx = _mm_loadu_ps(vel_x + i);
+            vy = _mm_loadu_ps(vel_y + i);
+            px = _mm_loadu_ps(pos_x + i);
+            py = _mm_loadu_ps(pos_y + i);
+            kk = _mm_loadu_ps(k + i);
+        }
+        else
+        {
+            vx = _mm_setr_ps(vel_x[idx[0]], vel_x[idx[1]], vel_x[idx[2]],
+                             vel_x[idx[3]]);
+            vy = _mm_setr_ps(vel_y[idx[0]], vel_y[idx[1]], vel_y[idx[2]],
+                             vel_y[idx[3]]);
+            px = _mm_setr_ps(pos_x[idx[0]], pos_x[idx[1]], pos_x[idx[2]],
+                             pos_x[idx[3]]);
+            py = _mm_setr_ps(pos_y[idx[0]], pos_y[idx[1]], pos_y[idx[2]],
+                             pos_y[idx[3]]);
+            kk = _mm_setr_ps(k[idx[0]], k[idx[1]], k[idx[2]], k[idx[3]]);
+        }
+
+        const __m128 damping = exp_sse2(_mm_mul_ps(kk, vneg_dt));
+        vx = _mm_mul_ps(vx, damping);
+        vy = _mm_add_ps(_mm_mul_ps(vy, damping), vgravity);
+        if (field)
+        {
+            __m128 ax, ay;
+            sample_field_sse2(*field, px, py, ax, ay);
+            vx = _mm_add_ps(vx, _mm_mul_ps(ax, vdt));
+            vy = _mm_add_ps(vy, _mm_mul_ps(ay, vdt));
+        }
+        px = _mm_add_ps(px, _mm_mul_ps(vx, vdt));
+        py = _mm_add_ps(py, _mm_mul_ps(vy, vdt));
+
+        if (contiguous)
+        {
+            const u32 i = idx[0];
+            _mm_storeu_ps(vel_x + i, vx);
+            _mm_storeu_ps(vel_y + i, vy);
+            _mm_storeu_ps(pos_x + i, px);
+            _mm_storeu_ps(pos_y + i, py);
+        }
+        else
+        {
+            alignas(16) float out[4][4];
+            _mm_store_ps(out[0], vx);
+            _mm_store_ps(out[1], vy);
+            _mm_store_ps(out[2], px);
+            _mm_store_ps(out[3], py);
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                const u32 i = idx[lane];
+                vel_x[i] = out[0][lane];
+                vel_y[i] = out[1][lane];
+                pos_x[i] = out[2][lane];
+                pos_y[i] = out[3][lane];
+            }
+        }
+    }
+
+    // Tail
+    integrate_particles_scalar(indices + n, count - n, pos_x, pos_y, vel_x,
+                               vel_y, k, dt, gravity_dv, field);
+}
+
+#endif // SIM_X86
+
+// ########## DISPATCH ##########
+
+SimdLevel detect_simd_level()
+{
+#ifdef SIM_X86
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return SimdLevel::AVX2;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        const bool avx2 = (info[1] & (1 << 5)) != 0;
+        __cpuid(info, 1);
+        const bool fma = (info[2] & (1 << 12)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (avx2 && fma && osxsave && (_xgetbv(0) & 0x6) == 0x6)
+            return SimdLevel::AVX2;
+    }
+#endif
+    return SimdLevel::SSE2;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+static SimdLevel active_backend = detect_simd_level();
+
+void set_integrate_backend(SimdLevel level)
+{
+    active_backend = std::min(level, detect_simd_level());
+}
+
+SimdLevel integrate_backend() { return active_backend; }
+
+const char *simd_level_name(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX2:
+        return "AVX2";
+    case SimdLevel::SSE2:
+        return "SSE2";
+    default:
+        return "scalar";
+    }
+}
+
+void integrate_particles(const u32 *indices, size_t count, float *pos_x,
+                         float *pos_y, float *vel_x, float *vel_y,
+                         const float *k, float dt, float gravity_dv,
+                         const ForceGrid *field)
+{
+    switch (active_backend)
+    {
+#ifdef SIM_X86
+    case SimdLevel::AVX2:
+        integrate_particles_avx2(indices, count, pos_x, pos_y, vel_x, vel_y,
+                                 k, dt, gravity_dv, field);
+        return;
+    case SimdLevel::SSE2:
+        integrate_particles_sse2(indices, count, pos_x, pos_y, vel_x, vel_y,
+                                 k, dt, gravity_dv, field);
+        return;
+#endif
+    default:
+        integrate_particles_scalar(indices, count, pos_x, pos_y, vel_x, vel_y,
+                                   k, dt, gravity_dv, field);
+        return;
+    }
+}
@@ -0,0 +1,170 @@
+// AVX2 + FMA backend of integrate_particles (8 lanes). This file is built
+// with AVX2/FMA code generation enabled and is only called after the runtime
+// check in detect_simd_level().
+
+#include "systems/integrate.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||             \
+    defined(_M_IX86)
+
+#include <immintrin.h>
+
+// e^x for x in [-87, 88]: range reduction to r in [-ln2/2, ln2/2], degree 6
+// Taylor polynomial for e^r, then scale by 2^n through the exponent bits.
+// Max relative error ~2e-7.
+static inline __m256 exp_avx2(__m256 x)
+{
+    x = _mm256_max_ps(x, _mm256_set1_ps(-87.0f));
+    x = _mm256_min_ps(x, _mm256_set1_ps(88.0f));
+
+    const __m256 n =
+        _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504f)),
+                        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+
+    __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+    r = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), r);
+
+    __m256 p = _mm256_set1_ps(1.0f / 720.0f);
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f / 120.0f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f / 24.0f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f / 6.0f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(0.5f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f));
+
+    const __m256i bits = _mm256_slli_epi32(
+        _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(bits));
+}
+
+// Field acceleration at eight positions: the cell and weights are computed
+// in lanes and the four corner nodes of each array are gathered
+static inline void sample_field_avx2(const ForceGrid &grid, __m256 px,
+                                     __m256 py, __m256 &ax, __m256 &ay)
+{
+    const __m256 gx = _mm256_min_ps(
+        _mm256_max_ps(_mm256_mul_ps(px, _mm256_set1_ps(grid.inv_cell)),
+                      _mm256_setzero_ps()),
+        _mm256_set1_ps(static_cast<float>(grid.cols - 1)));
+    const __m256 gy = _mm256_min_ps(
+        _mm256_max_ps(_mm256_mul_ps(py, _mm256_set1_ps(grid.inv_cell)),
+                      _mm256_setzero_ps()),
+        _mm256_set1_ps(static_cast<float>(grid.rows - 1)));
+
+    // Truncation of non-negative values, lower node one short of the last
+    const __m256i c = _mm256_cvttps_epi32(_mm256_min_ps(
+        gx, _mm256_set1_ps(static_cast<float>(grid.cols - 2))));
+    const __m256i r = _mm256_cvttps_epi32(_mm256_min_ps(
+        gy, _mm256_set1_ps(static_cast<float>(grid.rows - 2))));
+    const __m256 tx = _mm256_sub_ps(gx, _mm256_cvtepi32_ps(c));
+    const __m256 ty = _mm256_sub_ps(gy, _mm256_cvtepi32_ps(r));
+
+    const __m256i cols = _mm256_set1_epi32(static_cast<int>(grid.cols));
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i top = _mm256_add_epi32(_mm256_mullo_epi32(r, cols), c);
+    const __m256i bottom = _mm256_add_epi32(top, cols);
+    const __m256i top_right = _mm256_add_epi32(top, one);
+    const __m256i bottom_right = _mm256_add_epi32(bottom, one);
+
+    auto bilinear = [&](const float *values)
+    {
+        const __m256 v00 = _mm256_i32gather_ps(values, top, 4);
+        const __m256 v01 = _mm256_i32gather_ps(values, top_right, 4);
+        const __m256 v10 = _mm256_i32gather_ps(values, bottom, 4);
+        const __m256 v11 = _mm256_i32gather_ps(values, bottom_right, 4);
+        const __m256 t = _mm256_fmadd_ps(tx, _mm256_sub_ps(v01, v00), v00);
+        const __m256 b = _mm256_fmadd_ps(tx, _mm256_sub_ps(v11, v10), v10);
+        return _mm256_fmadd_ps(ty, _mm256_sub_ps(b, t), t);
+    };
+    ax = bilinear(grid.ax);
+    ay = bilinear(grid.ay);
+}
+
+void integrate_particles_avx2(const u32 *indices, size_t count, float *pos_x,
+                              float *pos_y, float *vel_x, float *vel_y,
+                              const float *k, float dt, float gravity_dv,
+                              const ForceGrid *field)
+{
+    const __m256 vdt = _mm256_set1_ps(dt);
+    const __m256 vneg_dt = _mm256_set1_ps(-dt);
+    const __m256 vgravity = _mm256_set1_ps(gravity_dv);
+    const __m256i lane_offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        const u32 *idx = indices + n;
+        const __m256i vidx =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(idx));
+
+        // Contiguous run if idx == idx[0] + {0..7}
+        const __m256i expected = _mm256_add_epi32(
+            _mm256_set1_epi32(static_cast<int>(idx[0])), lane_offsets);
+        const bool contiguous =
+            _mm256_movemask_epi8(_mm256_cmpeq_epi32(vidx, expected)) == -1;
+
+        __m256 vx, vy, px, py, kk;
+        if (contiguous)
+        {
+            const u32 i = idx[0];
+            vx = _mm256_loadu_ps(vel_x + i);
+            vy = _mm256_loadu_ps(vel_y + i);
+            px = _mm256_loadu_ps(pos_x + i);
+            py = _mm256_loadu_ps(pos_y + i);
+            kk = _mm256_loadu_ps(k + i);
+        }
+        else
+        {
+            vx = _mm256_i32gather_ps(vel_x, vidx, 4);
+            vy = _mm256_i32gather_ps(vel_y, vidx, 4);
+            px = _mm256_i32gather_ps(pos_x, vidx, 4);
+            py = _mm256_i32gather_ps(pos_y, vidx, 4);
+            kk = _mm256_i32gather_ps(k, vidx, 4);
+        }
+
+        const __m256 damping = exp_avx2(_mm256_mul_ps(kk, vneg_dt));
+        vx = _mm256_mul_ps(vx, damping);
+        vy = _mm256_fmadd_ps(vy, damping, vgravity);
+        if (field)
+        {
+            __m256 ax, ay;
+            sample_field_avx2(*field, px, py, ax, ay);
+            vx = _mm256_fmadd_ps(ax, vdt, vx);
+            vy = _mm256_fmadd_ps(ay, vdt, vy);
+        }
+        px = _mm256_fmadd_ps(vx, vdt, px);
+        py = _mm256_fmadd_ps(vy, vdt, py);
+
+        if (contiguous)
+        {
+            const u32 i = idx[0];
+            _mm256_storeu_ps(vel_x + i, vx);
+            _mm256_storeu_ps(vel_y + i, vy);
+            _mm256_storeu_ps(pos_x + i, px);
+            _mm256_storeu_ps(pos_y + i, py);
+        }
+        else
+        {
+            // AVX2 has no scatter
+            alignas(32) float out[4][8];
+            _mm256_store_ps(out[0], vx);
+            _mm256_store_ps(out[1], vy);
+            _mm256_store_ps(out[2], px);
+            _mm256_store_ps(out[3], py);
+            for (int lane = 0; lane < 8; ++lane)
+            {
+                const u32 i = idx[lane];
+                vel_x[i] = out[0][lane];
+                vel_y[i] = out[1][lane];
+                pos_x[i] = out[2][lane];
+                pos_y[i] = out[3][lane];
+            }
+        }
+    }
+
+    // Tail
+    integrate_particles_scalar(indices + n, count - n, pos_x, pos_y, vel_x,
+                               vel_y, k, dt, gravity_dv, field);
+}
+
+#endif
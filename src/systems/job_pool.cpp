@@ -0,0 +1,117 @@
+#include "systems/job_pool.h"
+
+#include <algorithm>
+
+JobPool::JobPool(unsigned thread_count)
+{
+    if (thread_count == 0)
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    _worker_count = thread_count;
+    _runs = std::make_unique<ChunkRun[]>(_worker_count);
+
+    // Worker 0 is the thread calling parallelFor
+    _threads.reserve(_worker_count - 1);
+    for (unsigned worker = 1; worker < _worker_count; ++worker)
+        _threads.emplace_back(&JobPool::_workerLoop, this, worker);
+}
+
+JobPool::~JobPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+
+    for (auto &thread : _threads)
+        thread.join();
+}
+
+void JobPool::parallelFor(size_t count, size_t chunk, const RangeFn &fn)
+{
+    if (count == 0)
+        return;
+
+    chunk = std::max<size_t>(1, chunk);
+    const size_t chunks = (count + chunk - 1) / chunk;
+
+    // Not worth waking anyone for a single chunk
+    if (_worker_count == 1 || chunks == 1)
+    {
+        fn(0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        // Deal chunks out as evenly sized contiguous runs
+        for (unsigned worker = 0; worker < _worker_count; ++worker)
+        {
+            _runs[worker].next.store(chunks * worker / _worker_count,
+                                     std::memory_order_relaxed);
+            _runs[worker].end = chunks * (worker + 1) / _worker_count;
+        }
+
+        _fn = &fn;
+        _count = count;
+        _chunk = chunk;
+        _busy = _worker_count - 1;
+        ++_generation;
+    }
+    _wake.notify_all();
+
+    _drain(0);
+
+    // Wait for the helpers so `fn` and the chunk runs stay valid
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this] { return _busy == 0; });
+    _fn = nullptr;
+}
+
+void JobPool::_workerLoop(unsigned worker)
+{
+    size_t seen_generation = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [&] {
+                return _stopping || _generation != seen_generation;
+            });
+            if (_stopping)
+                return;
+            seen_generation = _generation;
+        }
+
+        _drain(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_busy == 0)
+                _done.notify_one();
+        }
+    }
+}
+
+void JobPool::_drain(unsigned worker)
+{
+    // Own run first, then steal from the others in round-robin order
+    for (unsigned offset = 0; offset < _worker_count; ++offset)
+    {
+        ChunkRun &run = _runs[(worker + offset) % _worker_count];
+
+        for (;;)
+        {
+            size_t index = run.next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= run.end)
+                break;
+
+            size_t begin = index * _chunk;
+            size_t end = std::min(begin + _chunk, _count);
+            (*_fn)(begin, end, worker);
+        }
+    }
+}
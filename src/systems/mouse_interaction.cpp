@@ -0,0 +1,303 @@
+#include "systems/mouse_interaction.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "utils/globals.h"
+
+// Mouse push tuning
+static constexpr float OUT_OFFSET = 1.0f;
+static constexpr float OFFSET_TIME =
+    1.0f; // Time in seconds to smoothly push rectangle out
+static constexpr float EPS = 1e-6f;
+
+// Candidates evaluated per block, small enough for the results to stay in L1
+static constexpr size_t PUSH_BLOCK = 256;
+
+// Most cells along either side of the grid mouse_push_path bins its
+// candidates into
+static constexpr u32 PATH_GRID_MAX_SIDE = 256;
+
+// Paths with fewer capsules scan every candidate per capsule, in one cell
+static constexpr size_t PATH_GRID_MIN_CAPSULES = 4;
+
+MouseCapsule make_mouse_capsule(float prev_x, float prev_y, float x, float y,
+                                float sample_dt, float particle_radius)
+{
+    MouseCapsule c;
+    c.ax = prev_x;
+    c.ay = prev_y;
+    c.bx = x;
+    c.by = y;
+    c.sx = x - prev_x;
+    c.sy = y - prev_y;
+
+    const float len2 = c.sx * c.sx + c.sy * c.sy;
+    c.inv_len2 = len2 > 0.0f ? 1.0f / len2 : 0.0f;
+    c.radius = MOUSE_RADIUS + particle_radius;
+
+    // No cursor samples yet (or two with the same timestamp): treat the mouse
+    // as still instead of dividing by zero
+    c.vx = 0.0f;
+    c.vy = 0.0f;
+    if (sample_dt > 0.0f)
+    {
+        c.vx = c.sx / sample_dt;
+        c.vy = c.sy / sample_dt;
+    }
+    c.speed = std::sqrt(c.vx * c.vx + c.vy * c.vy);
+    c.dt = sample_dt;
+
+    c.min_x = std::min(prev_x, x) - c.radius;
+    c.max_x = std::max(prev_x, x) + c.radius;
+    c.min_y = std::min(prev_y, y) - c.radius;
+    c.max_y = std::max(prev_y, y) + c.radius;
+    return c;
+}
+
+// ########## CURSOR PATH ##########
+
+struct MouseSample
+{
+    float x, y;
+    float t;
+};
+
+// Samples recorded since the last take_mouse_path(); the first one is where
+// the previous path ended (the anchor), if the cursor has been seen
+static std::vector<MouseSample> mouse_samples;
+
+void record_mouse_sample(float x, float y, float t)
+{
+    if (!mouse_samples.empty())
+    {
+        const MouseSample &last = mouse_samples.back();
+        const float dx = x - last.x;
+        const float dy = y - last.y;
+        if (dx * dx + dy * dy < MOUSE_SAMPLE_SPACING * MOUSE_SAMPLE_SPACING)
+            return;
+
+        // A stalled frame keeps its first samples and the newest position
+        if (mouse_samples.size() >= MOUSE_PATH_MAX_SAMPLES)
+            mouse_samples.pop_back();
+    }
+    mouse_samples.push_back({x, y, t});
+}
+
+void reset_mouse_path() { mouse_samples.clear(); }
+
+void take_mouse_path(float particle_radius, MousePath &path)
+{
+    path.capsules.clear();
+    path.min_x = path.min_y = std::numeric_limits<float>::infinity();
+    path.max_x = path.max_y = -std::numeric_limits<float>::infinity();
+    if (mouse_samples.empty())
+        return;
+
+    if (mouse_samples.size() == 1)
+    {
+        // Still cursor
+        const MouseSample &at = mouse_samples.front();
+        path.capsules.push_back(
+            make_mouse_capsule(at.x, at.y, at.x, at.y, 0.0f, particle_radius));
+    }
+    for (size_t n = 1; n < mouse_samples.size(); ++n)
+    {
+        const MouseSample &a = mouse_samples[n - 1];
+        const MouseSample &b = mouse_samples[n];
+        path.capsules.push_back(make_mouse_capsule(a.x, a.y, b.x, b.y,
+                                                   b.t - a.t,
+                                                   particle_radius));
+    }
+
+    for (const MouseCapsule &c : path.capsules)
+    {
+        path.min_x = std::min(path.min_x, c.min_x);
+        path.max_x = std::max(path.max_x, c.max_x);
+        path.min_y = std::min(path.min_y, c.min_y);
+        path.max_y = std::max(path.max_y, c.max_y);
+    }
+
+    // The last sample anchors the next path
+    mouse_samples.front() = mouse_samples.back();
+    mouse_samples.resize(1);
+}
+
+// ########## PUSH ##########
+
+void mouse_push_batch(const MouseCapsule &c, const MouseCandidates &candidates,
+                      std::vector<MousePush> &out, u16 segment)
+{
+    // Per-frame terms. The outward push is scaled by mouse speed to handle
+    // fast movements, but capped to prevent skyrocketing; the push along the
+    // cursor's motion grows with penetration depth (0..1) and alignment.
+    const float push_scale =
+        (1.0f + std::min(c.speed * 0.05f, RECT_SIM_WIDTH)) / OFFSET_TIME;
+    const float target_distance = c.radius + OUT_OFFSET;
+    const bool cursor_moving = c.speed > EPS;
+    const float mvx = cursor_moving ? c.vx / c.speed : 0.0f;
+    const float mvy = cursor_moving ? c.vy / c.speed : 0.0f;
+    const float drive =
+        cursor_moving ? c.speed * c.dt * MOUSE_MASS / c.radius : 0.0f;
+
+    float dvx[PUSH_BLOCK];
+    float dvy[PUSH_BLOCK];
+    float dist[PUSH_BLOCK];
+    float along[PUSH_BLOCK];
+
+    const size_t count = candidates.size();
+    for (size_t base = 0; base < count; base += PUSH_BLOCK)
+    {
+        const size_t n = std::min(PUSH_BLOCK, count - base);
+        const float *px = candidates.x.data() + base;
+        const float *py = candidates.y.data() + base;
+
+        // ---------- evaluate: branch-free, vectorizable ----------
+        for (size_t j = 0; j < n; ++j)
+        {
+            // Closest point on the cursor segment
+            const float wx = px[j] - c.ax;
+            const float wy = py[j] - c.ay;
+            float t = (wx * c.sx + wy * c.sy) * c.inv_len2;
+            t = std::min(std::max(t, 0.0f), 1.0f);
+            const float dx = wx - c.sx * t;
+            const float dy = wy - c.sy * t;
+            const float d = std::sqrt(dx * dx + dy * dy);
+
+            // Out along the normal from the segment, reaching the target
+            // distance in OFFSET_TIME. Conditions become 0/1 factors so the
+            // loop has no branches.
+            const float normal = (target_distance - d) * push_scale /
+                                 std::max(d, EPS) * (d > EPS ? 1.0f : 0.0f);
+
+            // Along the cursor's motion, only for pieces in front of it
+            const float rx = px[j] - c.bx;
+            const float ry = py[j] - c.by;
+            const float r_len = std::sqrt(rx * rx + ry * ry);
+            const float dot = (mvx * rx + mvy * ry) / std::max(r_len, EPS) *
+                              (r_len > EPS ? 1.0f : 0.0f);
+            const float a = drive * (c.radius - d) * std::max(dot, 0.0f);
+
+            dvx[j] = dx * normal + mvx * a;
+            dvy[j] = dy * normal + mvy * a;
+            dist[j] = d;
+            along[j] = a;
+        }
+
+        // ---------- compact the hits ----------
+        for (size_t j = 0; j < n; ++j)
+        {
+            if (dist[j] < c.radius)
+            {
+                out.push_back({candidates.index[base + j], dvx[j], dvy[j],
+                               segment, static_cast<u8>(along[j] > 0.0f)});
+            }
+        }
+    }
+}
+
+void mouse_push_path(const MousePath &path, const MouseCandidates &candidates,
+                     MousePathScratch &scratch, std::vector<MousePush> &out)
+{
+    const size_t count = candidates.size();
+    if (count == 0 || path.empty())
+        return;
+    scratch.pending.assign(count, 1);
+
+    // ---------- bin the candidates once ----------
+    // Cells about as wide as a capsule, over the path's bounding box and
+    // stored row-major, so the cells a capsule's box covers in one row are
+    // one contiguous slice of `binned`
+    const bool grid = path.capsules.size() >= PATH_GRID_MIN_CAPSULES;
+    const float cell = 2.0f * path.capsules.front().radius;
+    const float width = std::max(path.max_x - path.min_x, cell);
+    const float height = std::max(path.max_y - path.min_y, cell);
+    const u32 cols =
+        grid ? std::min(PATH_GRID_MAX_SIDE,
+                        static_cast<u32>(std::ceil(width / cell)))
+             : 1;
+    const u32 rows =
+        grid ? std::min(PATH_GRID_MAX_SIDE,
+                        static_cast<u32>(std::ceil(height / cell)))
+             : 1;
+    const float inv_x = static_cast<float>(cols) / width;
+    const float inv_y = static_cast<float>(rows) / height;
+    const auto col = [&](float x)
+    {
+        const float c = std::max((x - path.min_x) * inv_x, 0.0f);
+        return std::min(static_cast<u32>(c), cols - 1);
+    };
+    const auto row = [&](float y)
+    {
+        const float r = std::max((y - path.min_y) * inv_y, 0.0f);
+        return std::min(static_cast<u32>(r), rows - 1);
+    };
+
+    // Counting sort by cell; within a cell candidates keep their order
+    std::vector<u32> &cell_start = scratch.cell_start;
+    cell_start.assign(size_t(cols) * rows + 1, 0);
+    scratch.cell_of.resize(count);
+    for (size_t j = 0; j < count; ++j)
+    {
+        const u32 c = row(candidates.y[j]) * cols + col(candidates.x[j]);
+        scratch.cell_of[j] = c;
+        ++cell_start[c + 1];
+    }
+    for (size_t c = 1; c < cell_start.size(); ++c)
+        cell_start[c] += cell_start[c - 1];
+    scratch.binned.resize(count);
+    scratch.cursor.assign(cell_start.begin(), cell_start.end() - 1);
+    for (size_t j = 0; j < count; ++j)
+        scratch.binned[scratch.cursor[scratch.cell_of[j]]++] =
+            static_cast<u32>(j);
+
+    // ---------- sweep the capsules in order ----------
+    for (size_t segment = 0; segment < path.capsules.size(); ++segment)
+    {
+        const MouseCapsule &capsule = path.capsules[segment];
+        const u32 col_begin = col(capsule.min_x);
+        const u32 col_end = col(capsule.max_x);
+        const u32 row_end = row(capsule.max_y);
+
+        // Candidate positions near the capsule, by cell
+        std::vector<u32> &near = scratch.near;
+        near.clear();
+        for (u32 r = row(capsule.min_y); r <= row_end; ++r)
+        {
+            const u32 first = cell_start[r * cols + col_begin];
+            const u32 last = cell_start[r * cols + col_end + 1];
+            for (u32 n = first; n < last; ++n)
+            {
+                const u32 j = scratch.binned[n];
+                if (scratch.pending[j] &&
+                    capsule.mayContain(candidates.x[j], candidates.y[j]))
+                    near.push_back(j);
+            }
+        }
+
+        // The subset refers to candidates by position, so hits can be
+        // retired and mapped back to particle indices
+        scratch.subset.clear();
+        for (u32 j : near)
+            scratch.subset.add(j, candidates.x[j], candidates.y[j]);
+
+        const size_t first = out.size();
+        mouse_push_batch(capsule, scratch.subset, out,
+                         static_cast<u16>(segment));
+
+        // Hits in candidate order, as a scan of the whole list gives them;
+        // the caller applies them in this order
+        const auto by_index = [](const MousePush &a, const MousePush &b)
+        { return a.index < b.index; };
+        if (!std::is_sorted(out.begin() + first, out.end(), by_index))
+            std::sort(out.begin() + first, out.end(), by_index);
+        for (size_t h = first; h < out.size(); ++h)
+        {
+            const u32 j = out[h].index;
+            scratch.pending[j] = 0;
+            out[h].index = candidates.index[j];
+        }
+    }
+}
@@ -0,0 +1,318 @@
+#include "systems/sim_thread.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "entities/particles.h"
+#include "systems/emitters.h"
+#include "systems/mouse_interaction.h"
+#include "systems/simulation.h"
+#include "utils/globals.h"
+#include "utils/triple_buffer.h"
+
+// ########## INPUT QUEUE ##########
+
+// Posted inputs; the simulation swaps the whole list out at the start of a
+// frame, so the lock is held for a push_back or a swap
+static std::mutex input_mutex;
+static std::vector<SimInput> posted_inputs;
+static std::vector<SimInput> frame_inputs; // simulation side of the swap
+
+void post_simulation_input(const SimInput &input)
+{
+    std::lock_guard<std::mutex> lock(input_mutex);
+    posted_inputs.push_back(input);
+}
+
+static void apply_input(const SimInput &input)
+{
+    switch (input.kind)
+    {
+    case SimInput::Kind::Burst:
+        rectangle_count += static_cast<int>(
+            spawn_burst(input.x, input.y, input.count, simulation_time()));
+        break;
+
+    case SimInput::Kind::MouseSample:
+        record_mouse_sample(input.x, input.y, input.t);
+        set_emitter_cursor(input.x, input.y);
+        break;
+
+    case SimInput::Kind::HoldSpawn:
+        set_hold_spawn(input.on);
+        break;
+
+    case SimInput::Kind::Call:
+        if (input.call)
+            input.call();
+        break;
+    }
+}
+
+static void apply_inputs()
+{
+    {
+        std::lock_guard<std::mutex> lock(input_mutex);
+        frame_inputs.swap(posted_inputs);
+    }
+    for (const SimInput &input : frame_inputs)
+        apply_input(input);
+    frame_inputs.clear();
+}
+
+// ########## SNAPSHOTS ##########
+
+static TripleBuffer<SimSnapshot> snapshots;
+
+// ---------- settled changes ----------
+
+// Settled record ranges changed by frames the renderer may not have seen,
+// stamped with the frame that changed them
+struct SettledChange
+{
+    u64 frame;
+    obj::RecordRange range;
+};
+static std::vector<SettledChange> settled_journal;
+static u64 settled_rebuilt = 0; // last frame that renumbered the records
+
+// Newest snapshot the render thread took; it applies the changes up to it
+static std::atomic<u64> rendered_frame{0};
+
+static void capture_settled(SimSnapshot &out, u64 frame)
+{
+    obj::SettledArchive &archive = particles.settled;
+    for (const obj::RecordRange &range : archive.changes())
+        settled_journal.push_back({frame, range});
+
+    // A renderer that stops taking snapshots gets the whole set again
+    // rather than an ever longer journal
+    if (archive.allChanged() ||
+        settled_journal.size() > obj::ARCHIVE_MAX_CHANGES)
+    {
+        settled_rebuilt = frame;
+        settled_journal.clear();
+    }
+    archive.clearChanges();
+
+    const u64 seen = rendered_frame.load(std::memory_order_acquire);
+    std::erase_if(settled_journal, [seen](const SettledChange &change)
+                  { return change.frame <= seen; });
+
+    const u32 slots = static_cast<u32>(archive.slots());
+    out.settled = archive.size();
+    out.settled_slots = slots;
+    out.settled_rebuild = settled_rebuilt > seen;
+    out.settled_ranges.clear();
+    out.settled_changes.clear();
+
+    if (out.settled_rebuild)
+    {
+        if (slots > 0)
+            out.settled_ranges.push_back({0, slots});
+    }
+    else
+    {
+        // Sorted and merged, so every record is copied once
+        for (const SettledChange &change : settled_journal)
+            out.settled_ranges.push_back(change.range);
+        std::sort(out.settled_ranges.begin(), out.settled_ranges.end(),
+                  [](const obj::RecordRange &a, const obj::RecordRange &b)
+                  { return a.first < b.first; });
+
+        size_t merged = 0;
+        for (const obj::RecordRange &range : out.settled_ranges)
+        {
+            if (merged > 0 && range.first <= out.settled_ranges[merged - 1].end)
+            {
+                obj::RecordRange &last = out.settled_ranges[merged - 1];
+                last.end = std::max(last.end, range.end);
+            }
+            else
+                out.settled_ranges[merged++] = range;
+        }
+        out.settled_ranges.resize(merged);
+    }
+
+    for (const obj::RecordRange &range : out.settled_ranges)
+    {
+        for (u32 id = range.first; id < range.end; ++id)
+            out.settled_changes.push_back(archive[id]);
+    }
+}
+
+void capture_snapshot(SimSnapshot &out, u64 frame)
+{
+    const obj::ParticleStore &store = particles;
+    const size_t flying = store.active.size() + store.fading.size();
+
+    out.pos_x.resize(flying);
+    out.pos_y.resize(flying);
+    out.vel_x.resize(flying);
+    out.vel_y.resize(flying);
+    out.state_time.resize(flying);
+    out.spawn_time.resize(flying);
+    out.stop_time.resize(flying);
+    out.k.resize(flying);
+    out.color.resize(flying);
+    out.pitch.resize(flying);
+    out.yaw.resize(flying);
+    out.roll.resize(flying);
+    out.moving.resize(flying);
+
+    // Time of each piece's pos/vel: its launch for analytic flights, its
+    // block's latest step with level of detail, else the latest step
+    const bool analytic = motion_mode() == MotionMode::Analytic;
+    const bool per_piece = analytic || lod_enabled();
+    const float step_time = static_cast<float>(last_step_time());
+    const double launch_origin = launch_time_origin();
+
+    // Active pieces are airborne; a fading piece is frozen since its fade
+    // start, which the store keeps as its spawn time
+    size_t n = 0;
+    for (const std::vector<u32> *list : {&store.active, &store.fading})
+    {
+        const bool airborne = list == &store.active;
+        for (const u32 i : *list)
+        {
+            out.pos_x[n] = store.pos_x[i];
+            out.pos_y[n] = store.pos_y[i];
+            out.vel_x[n] = store.vel_x[i];
+            out.vel_y[n] = store.vel_y[i];
+            out.state_time[n] =
+                per_piece ? static_cast<float>(launch_origin +
+                                               store.launch_time[i])
+                          : step_time;
+            out.spawn_time[n] = store.spawn_time[i];
+            out.stop_time[n] = airborne ? 0.0f : store.spawn_time[i];
+            out.k[n] = store.k[i];
+            out.color[n] = store.color[i];
+            out.pitch[n] = store.pitch[i];
+            out.yaw[n] = store.yaw[i];
+            out.roll[n] = store.roll[i];
+            out.moving[n] = airborne ? 1 : 0;
+            ++n;
+        }
+    }
+
+    capture_settled(out, frame);
+
+    out.render_time = render_time();
+    out.gravity = gravity_acceleration();
+    out.drag = store.drag;
+    out.analytic = analytic;
+    out.active = store.active.size();
+    out.budget = particle_budget();
+    out.frame = frame;
+}
+
+const SimSnapshot &latest_snapshot()
+{
+    if (snapshots.acquire())
+        rendered_frame.store(snapshots.front().frame,
+                             std::memory_order_release);
+    return snapshots.front();
+}
+
+// ########## FRAMES ##########
+
+static std::thread sim_thread;
+static std::mutex frame_mutex;
+static std::condition_variable frame_requested;
+static std::condition_variable frame_finished;
+static u64 frames_requested = 0; // guarded by frame_mutex
+static u64 frames_finished = 0;  // guarded by frame_mutex
+static bool thread_stopping = false;
+
+// Inputs, steps, snapshot: everything the simulation does for one frame
+static void run_frame(u64 frame)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    apply_inputs();
+    advance_simulation();
+
+    SimSnapshot &snapshot = snapshots.back();
+    capture_snapshot(snapshot, frame);
+    snapshot.sim_seconds = std::chrono::duration<float>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    snapshots.publish();
+}
+
+static void simulation_loop()
+{
+    std::unique_lock<std::mutex> lock(frame_mutex);
+    for (;;)
+    {
+        frame_requested.wait(lock, []
+                             { return thread_stopping ||
+                                      frames_finished < frames_requested; });
+        if (thread_stopping)
+            return;
+
+        // Every request made so far is served by this frame
+        const u64 frame = frames_requested;
+        lock.unlock();
+        run_frame(frame);
+        lock.lock();
+
+        frames_finished = frame;
+        frame_finished.notify_all();
+    }
+}
+
+void start_simulation_thread()
+{
+    if (sim_thread.joinable())
+        return;
+    thread_stopping = false;
+    sim_thread = std::thread(simulation_loop);
+}
+
+void stop_simulation_thread()
+{
+    if (!sim_thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(frame_mutex);
+        thread_stopping = true;
+    }
+    frame_requested.notify_one();
+    sim_thread.join();
+
+    // Requests the thread never got to are dropped
+    std::lock_guard<std::mutex> lock(frame_mutex);
+    frames_requested = frames_finished;
+    frame_finished.notify_all();
+}
+
+bool simulation_thread_running() { return sim_thread.joinable(); }
+
+void request_simulation_frame()
+{
+    if (!sim_thread.joinable())
+    {
+        const u64 frame = ++frames_requested;
+        run_frame(frame);
+        frames_finished = frame;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(frame_mutex);
+        ++frames_requested;
+    }
+    frame_requested.notify_one();
+}
+
+void wait_simulation_frame()
+{
+    std::unique_lock<std::mutex> lock(frame_mutex);
+    frame_finished.wait(lock,
+                        [] { return frames_finished >= frames_requested; });
+}
@@ -0,0 +1,1143 @@
+#include "systems/simulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "entities/event_queue.h"
+#include "entities/particles.h"
+#include "systems/emitters.h"
+#include "systems/force_field.h"
+#include "systems/integrate.h"
+#include "systems/job_pool.h"
+#include "systems/mouse_interaction.h"
+#include "systems/trajectory.h"
+#include "utils/globals.h"
+
+// ########## SIMULATION CLOCK ##########
+
+// Seconds since the first call, used until a clock is installed
+static double steady_clock_seconds()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+        .count();
+}
+
+static SimClock sim_clock = steady_clock_seconds;
+
+void set_simulation_clock(SimClock clock)
+{
+    sim_clock = clock ? clock : steady_clock_seconds;
+}
+
+// Seconds dropped by advance_simulation after hitches
+static double dropped_seconds = 0.0;
+
+double simulation_time() { return sim_clock() - dropped_seconds; }
+
+// ########## FIXED STEP ##########
+
+static double step_seconds = 1.0 / 60.0;
+static int step_limit = 8;
+static double step_time = 0.0;     // time of the latest step
+static bool stepping = false;      // set by the first advance_simulation
+static float step_fraction = 0.0f; // step_alpha()
+
+// Rounding slack when counting due steps, so a display running at the step
+// rate does not lose a step to floating point
+static constexpr double STEP_EPSILON = 1e-6;
+
+void set_fixed_step(double seconds, int substeps)
+{
+    if (seconds > 0.0)
+        step_seconds = seconds;
+    if (substeps > 0)
+        step_limit = substeps;
+}
+
+double fixed_step() { return step_seconds; }
+int max_substeps() { return step_limit; }
+
+AdvanceResult advance_simulation()
+{
+    AdvanceResult result;
+    double now = simulation_time();
+    if (!stepping)
+    {
+        stepping = true;
+        step_time = now;
+        step_fraction = 0.0f;
+        return result;
+    }
+
+    // Whole steps only, so the fraction into the next step survives a drop
+    const double due =
+        std::floor((now - step_time) / step_seconds + STEP_EPSILON);
+    int steps = static_cast<int>(std::max(due, 0.0));
+    if (due > step_limit)
+    {
+        result.dropped = (due - step_limit) * step_seconds;
+        dropped_seconds += result.dropped;
+        now -= result.dropped;
+        steps = step_limit;
+    }
+
+    for (int n = 0; n < steps; ++n)
+    {
+        step_time += step_seconds;
+        result.emitted += update_emitters(step_time);
+        simulation_step(step_seconds, step_time);
+    }
+    result.steps = steps;
+
+    step_fraction = static_cast<float>(
+        std::clamp((now - step_time) / step_seconds, 0.0, 1.0));
+    return result;
+}
+
+double last_step_time() { return step_time; }
+
+float step_alpha() { return step_fraction; }
+
+double render_time()
+{
+    return step_time - (1.0 - step_fraction) * step_seconds;
+}
+
+// ########## SIMULATION STEP ##########
+
+// Seconds the launch time origin may fall behind the clock before it is
+// moved up; launch times after it keep about 30 µs resolution
+static constexpr double LAUNCH_ORIGIN_SPAN = 256.0;
+
+// Stale flight events tolerated beyond one per airborne particle before the
+// queue is rebuilt
+static constexpr size_t EVENT_SLACK = 4096;
+
+// Random stream of the mouse flick, apart from the spawn stream
+static constexpr u64 FLICK_STREAM = 1;
+
+// Edge length of the settled particle grid cells in world units
+static constexpr float SETTLED_CELL_SIZE = 8.0f;
+
+// Sideways speeds below this are flushed to zero, in world units/s
+static constexpr float MIN_DRIFT_SPEED = 1e-6f;
+
+// Below this many airborne particles the pool is not worth waking
+static constexpr size_t PARALLEL_THRESHOLD = 8192;
+// Particles per work item handed to the pool
+static constexpr size_t PARALLEL_CHUNK = 4096;
+
+// Active list entries per level-of-detail block; work items hold whole
+// blocks
+static constexpr size_t LOD_BLOCK = 64;
+static_assert(PARALLEL_CHUNK % LOD_BLOCK == 0, "work items split blocks");
+
+// Slowest tier: blocks are stepped every step, every 2nd or every 4th
+static constexpr u8 LOD_MAX_TIER = 2;
+
+// Fastest piece a block may hold in each tier, in pixels per step, and how
+// far one long step may bend off the short steps it replaces
+static constexpr float LOD_SPEED_PX[LOD_MAX_TIER + 1] = {0.0f, 1.0f, 0.25f};
+static constexpr float LOD_BEND_PX = 0.01f;
+
+// Most short steps a piece is caught up by at once
+static constexpr int LOD_MAX_CATCH_UP = 8;
+
+// Per-frame invariants shared by every worker
+struct StepFrame
+{
+    float dt;
+    double current_time;
+    float bbox_radius;
+    float gravity;    // acceleration in world units/s² (analytic flights)
+    float gravity_dv; // velocity gained from gravity this step
+    const ForceGrid *field; // null when no force field is enabled
+    float field_accel;      // strongest field acceleration (LOD tiers)
+    const MousePath *mouse;
+    u64 step;               // number of this step
+};
+
+// Transitions recorded for one chunk of the active list during the
+// parallel phase. Kept per chunk rather than per worker: chunks are stolen,
+// so which worker runs which one depends on timing, and the merge must not.
+struct TransitionBuffer
+{
+    std::vector<u32> to_settle;  // move to settled
+    std::vector<u32> to_release; // drop from active only
+    // Ends of the analytic flights re-launched by the mouse
+    std::vector<obj::TimedEvent> relaunched;
+    size_t stepped = 0; // pieces advanced by level-of-detail blocks
+};
+
+// Piece in a level-of-detail block whose pos/vel belong to another time
+// than the block's, and its state before the block was stepped
+struct LodStraggler
+{
+    u32 index;
+    float time; // launch_time
+    float x, y, vx, vy;
+};
+
+// Working memory of one worker, reused for every chunk it runs
+struct WorkerScratch
+{
+    MouseCandidates candidates; // airborne pieces the mouse may reach
+    MousePathScratch path_scratch;
+    std::vector<MousePush> pushes;
+    std::vector<u32> due_blocks; // level-of-detail blocks stepped now
+    std::vector<LodStraggler> stragglers;
+};
+
+// This frame's cursor path and the settled pieces it may wake, reused
+// across frames
+static MousePath mouse_path;
+static MouseCandidates settled_candidates;
+static std::vector<MousePush> settled_pushes;
+static std::vector<u8> settled_pushed; // per record id: pushed this frame
+static std::vector<TransitionBuffer> transitions(1); // per chunk
+static std::vector<WorkerScratch> worker_scratch(1);
+static u64 step_count = 0;
+
+static unsigned physics_thread_count = 0; // 0 = hardware concurrency
+static std::unique_ptr<JobPool> pool_instance;
+
+JobPool &physics_pool()
+{
+    if (!pool_instance)
+        pool_instance = std::make_unique<JobPool>(physics_thread_count);
+    return *pool_instance;
+}
+
+void set_simulation_threads(unsigned thread_count)
+{
+    physics_thread_count = thread_count;
+    pool_instance.reset();
+}
+
+unsigned simulation_threads() { return physics_pool().size(); }
+
+// ########## MOTION MODE ##########
+
+static MotionMode motion = MotionMode::Integrated;
+// Gravity the current analytic flights were launched with
+static float launch_gravity = 0.0f;
+// Predicted flight ends, earliest first. Relaunching pushes a new event and
+// leaves the old one behind; it is skipped because the particle's flight
+// number has moved on.
+static obj::EventQueue flight_events;
+static std::vector<obj::TimedEvent> launch_events; // launch_particles()
+// ParticleStore::launch_time counts seconds from here
+static double launch_origin = 0.0;
+// Level of detail, see set_lod_enabled()
+static bool lod_on = true;
+
+MotionMode motion_mode() { return motion; }
+
+float gravity_acceleration()
+{
+    return apply_gravity ? GRAVITY_ACCELERATION * (RECT_WIDTH + 1) : 0.0f;
+}
+
+double launch_time_origin() { return launch_origin; }
+
+// `time` as a launch time, relative to the origin
+static float since_launch_origin(double time)
+{
+    return static_cast<float>(time - launch_origin);
+}
+
+// Move the launch time origin to `time`, rewriting the launch times of
+// every airborne piece
+static void move_launch_origin(double time)
+{
+    for (u32 i : particles.active)
+    {
+        particles.launch_time[i] = static_cast<float>(
+            launch_origin + particles.launch_time[i] - time);
+    }
+    launch_origin = time;
+}
+
+// Start a new flight of i from its launch state: bump its flight number and
+// predict when and how the flight ends. Whether it lands is kept on the
+// event rather than read back from the position when it comes due, which at
+// a float-rounded time can miss the floor by more than any fixed slack.
+static obj::TimedEvent predict_flight_end(u32 i)
+{
+    const float r = particles.radius;
+    bool lands;
+    const double tau = trajectory_end(
+        particles.pos_x[i], particles.pos_y[i], particles.vel_x[i],
+        particles.vel_y[i], particles.k[i], launch_gravity, world_height - r,
+        -r, world_width + r, lands);
+    const u16 flight = ++particles.flight[i];
+    return {launch_origin + particles.launch_time[i] + tau, i, flight,
+            static_cast<u8>(lands)};
+}
+
+void launch_particle(u32 index, double time)
+{
+    particles.launch_time[index] = since_launch_origin(time);
+    if (motion == MotionMode::Analytic)
+        flight_events.push(predict_flight_end(index));
+}
+
+void launch_particles(const u32 *indices, size_t count, double time)
+{
+    const float t = since_launch_origin(time);
+    for (size_t n = 0; n < count; ++n)
+        particles.launch_time[indices[n]] = t;
+    if (motion != MotionMode::Analytic)
+        return;
+
+    // Predictions are independent; large batches split across the pool
+    launch_events.resize(count);
+    const auto predict = [indices](size_t begin, size_t end, unsigned)
+    {
+        for (size_t n = begin; n < end; ++n)
+            launch_events[n] = predict_flight_end(indices[n]);
+    };
+    if (count < PARALLEL_THRESHOLD)
+        predict(0, count, 0);
+    else
+        physics_pool().parallelFor(count, PARALLEL_CHUNK, predict);
+
+    flight_events.push(launch_events.data(), count);
+}
+
+// Current state of an analytic flight
+static void flight_state(u32 i, double time, float &x, float &y, float &vx,
+                         float &vy)
+{
+    trajectory_at(particles.pos_x[i], particles.pos_y[i], particles.vel_x[i],
+                  particles.vel_y[i], particles.k[i], launch_gravity,
+                  since_launch_origin(time) - particles.launch_time[i], x, y,
+                  vx, vy);
+}
+
+void particle_state_at(u32 index, double time, float &x, float &y, float &vx,
+                       float &vy)
+{
+    if (motion == MotionMode::Analytic &&
+        particles.list_id[index] == obj::LIST_ACTIVE)
+    {
+        flight_state(index, time, x, y, vx, vy);
+        return;
+    }
+
+    x = particles.pos_x[index];
+    y = particles.pos_y[index];
+    vx = particles.vel_x[index];
+    vy = particles.vel_y[index];
+
+    // A level-of-detail block may be a few steps behind
+    if (motion == MotionMode::Integrated && lod_on &&
+        particles.list_id[index] == obj::LIST_ACTIVE)
+    {
+        const float ahead =
+            since_launch_origin(time) - particles.launch_time[index];
+        x += vx * ahead;
+        y += vy * ahead;
+    }
+}
+
+// ########## LEVEL OF DETAIL ##########
+
+// LOD_BLOCK consecutive entries of the active list
+struct LodBlock
+{
+    double time = 0.0; // time its pieces' pos/vel belong to
+    // Box their centers stay in until the block is next due
+    float min_x = 0.0f, max_x = -1.0f;
+    float min_y = 0.0f, max_y = -1.0f;
+    u8 tier = 0;   // stepped every 2^tier steps
+    u8 forced = 1; // stepped next step whatever the tier
+};
+
+static std::vector<LodBlock> lod_blocks;
+// Length of the active list after the latest step; entries past it are new
+static size_t lod_active_size = 0;
+// Time and length of the latest step, and the pieces it advanced
+static double latest_step_time = 0.0;
+static float latest_step_dt = 1.0f / 60.0f;
+static size_t latest_step_count = 0;
+
+bool lod_enabled() { return lod_on; }
+
+size_t stepped_particles() { return latest_step_count; }
+
+// Velocity gravity adds over n steps of h seconds taken as one: the gains
+// of the short steps, each decayed by the drag of the steps after it, so
+// every tier falls at the same terminal velocity
+static float gravity_gain(float gravity, float drag, float h, int n)
+{
+    const float decay = std::exp(-drag * h);
+    if (n == 1 || 1.0f - decay < 1e-6f)
+        return gravity * h * static_cast<float>(n);
+    return gravity * h * (1.0f - std::pow(decay, static_cast<float>(n))) /
+           (1.0f - decay);
+}
+
+// Step piece i on its own from `from` to the frame's time, in steps about
+// as long as the frame's
+static void lod_advance(const StepFrame &f, u32 i, double from)
+{
+    const double span = f.current_time - from;
+    if (span <= 0.0)
+        return;
+
+    const int steps = std::clamp(static_cast<int>(std::lround(span / f.dt)),
+                                 1, LOD_MAX_CATCH_UP);
+    const float h = static_cast<float>(span / steps);
+    for (int s = 0; s < steps; ++s)
+    {
+        integrate_particles(&i, 1, particles.pos_x.data(),
+                            particles.pos_y.data(), particles.vel_x.data(),
+                            particles.vel_y.data(), particles.k.data(), h,
+                            f.gravity * h, f.field);
+    }
+}
+
+// Bring every airborne piece up to the latest step and forget the blocks
+static void lod_catch_up()
+{
+    StepFrame frame{};
+    frame.dt = latest_step_dt;
+    frame.current_time = latest_step_time;
+    frame.gravity = gravity_acceleration();
+    frame.field = force_grid();
+
+    const float now = since_launch_origin(latest_step_time);
+    for (u32 i : particles.active)
+    {
+        lod_advance(frame, i, launch_origin + particles.launch_time[i]);
+        particles.launch_time[i] = now;
+    }
+    lod_blocks.clear();
+    lod_active_size = 0;
+}
+
+void set_lod_enabled(bool enabled)
+{
+    if (enabled == lod_on)
+        return;
+
+    // Without LOD every integrated piece is at the latest step
+    if (motion == MotionMode::Integrated)
+    {
+        if (enabled)
+        {
+            launch_origin = latest_step_time;
+            for (u32 i : particles.active)
+                particles.launch_time[i] = 0.0f;
+        }
+        else
+        {
+            lod_catch_up();
+        }
+    }
+    lod_on = enabled;
+    lod_blocks.clear();
+    lod_active_size = 0;
+}
+
+// Fit the block table to the active list before a step. Blocks past the
+// end of the last step's list hold only new pieces and take their time from
+// the first of them; the block new pieces were appended to is due at once.
+static void lod_prepare_blocks()
+{
+    const std::vector<u32> &active = particles.active;
+    const size_t blocks = (active.size() + LOD_BLOCK - 1) / LOD_BLOCK;
+    const size_t kept = std::min(
+        lod_blocks.size(),
+        (std::min(lod_active_size, active.size()) + LOD_BLOCK - 1) /
+            LOD_BLOCK);
+
+    lod_blocks.resize(blocks);
+    if (active.size() > lod_active_size && lod_active_size % LOD_BLOCK != 0 &&
+        lod_active_size / LOD_BLOCK < kept)
+        lod_blocks[lod_active_size / LOD_BLOCK].forced = 1;
+    for (size_t b = kept; b < blocks; ++b)
+    {
+        lod_blocks[b] = LodBlock{};
+        lod_blocks[b].time =
+            launch_origin + particles.launch_time[active[b * LOD_BLOCK]];
+    }
+}
+
+// Airborne piece r is about to leave the active list and the last entry
+// will be swapped into its place: if that piece's time is not its new
+// block's, the block is stepped next time so it does not wait
+static void lod_note_removal(u32 r, float tolerance)
+{
+    const std::vector<u32> &active = particles.active;
+    if (particles.list_id[r] != obj::LIST_ACTIVE)
+        return;
+
+    const u32 slot = particles.list_slot[r];
+    const size_t b = slot / LOD_BLOCK;
+    if (slot + 1 == active.size() || b >= lod_blocks.size())
+        return;
+
+    const float moved = particles.launch_time[active.back()];
+    if (std::abs(moved - since_launch_origin(lod_blocks[b].time)) > tolerance)
+        lod_blocks[b].forced = 1;
+}
+
+// Slowest tier `block` may take until it is next due, from its fastest
+// piece's speed and acceleration and the box its pieces are in now; the
+// box is widened by how far they can travel until then
+static void lod_retier(const StepFrame &f, LodBlock &block, float speed,
+                       float accel, float min_x, float max_x, float min_y,
+                       float max_y)
+{
+    const float scale = world_scale;
+    u8 tier = LOD_MAX_TIER;
+    float travel = 0.0f;
+    for (; tier > 0; --tier)
+    {
+        const float n = static_cast<float>(1u << tier);
+        const float span = n * f.dt;
+        travel = speed * span + 0.5f * accel * span * span;
+
+        // Landings must not come late
+        if (max_y + f.bbox_radius + travel >= world_height)
+            continue;
+
+        // One long step bends off n short ones by a * dt² * n(n - 1) / 2
+        if (accel * f.dt * f.dt * n * (n - 1.0f) * 0.5f * scale >
+            LOD_BEND_PX)
+            continue;
+
+        // Above the visible area the speed is not seen
+        const bool hidden = max_y + f.bbox_radius + travel < 0.0f;
+        if (hidden || speed * f.dt * scale < LOD_SPEED_PX[tier])
+            break;
+    }
+    if (tier == 0)
+        travel = speed * f.dt + 0.5f * accel * f.dt * f.dt;
+
+    block.tier = tier;
+    block.min_x = min_x - travel;
+    block.max_x = max_x + travel;
+    block.min_y = min_y - travel;
+    block.max_y = max_y + travel;
+}
+
+// Strongest acceleration anywhere on the force grid
+static float field_peak(const ForceGrid &grid)
+{
+    float peak = 0.0f;
+    const size_t nodes = static_cast<size_t>(grid.cols) * grid.rows;
+    for (size_t n = 0; n < nodes; ++n)
+    {
+        peak = std::max(peak,
+                        grid.ax[n] * grid.ax[n] + grid.ay[n] * grid.ay[n]);
+    }
+    return std::sqrt(peak);
+}
+
+// ########## MODE SWITCHES ##########
+
+// Re-launch every airborne particle from its state at `time`, e.g. when
+// gravity changes mid-flight
+static void relaunch_active(double time, float new_gravity)
+{
+    for (u32 i : particles.active)
+    {
+        float x, y, vx, vy;
+        flight_state(i, time, x, y, vx, vy);
+        particles.pos_x[i] = x;
+        particles.pos_y[i] = y;
+        particles.vel_x[i] = vx;
+        particles.vel_y[i] = vy;
+    }
+
+    // Every queued end is stale now
+    launch_gravity = new_gravity;
+    flight_events.clear();
+    launch_particles(particles.active.data(), particles.active.size(), time);
+}
+
+void set_motion_mode(MotionMode mode)
+{
+    if (mode == motion)
+        return;
+
+    const double now = simulation_time();
+    if (mode == MotionMode::Analytic)
+    {
+        // Current pos/vel become the launch state
+        if (lod_on)
+            lod_catch_up();
+        motion = mode;
+        launch_gravity = gravity_acceleration();
+        launch_origin = now;
+        launch_particles(particles.active.data(), particles.active.size(),
+                         now);
+    }
+    else
+    {
+        // Write the current state back for the integrator
+        for (u32 i : particles.active)
+        {
+            flight_state(i, now, particles.pos_x[i], particles.pos_y[i],
+                         particles.vel_x[i], particles.vel_y[i]);
+        }
+        motion = mode;
+        flight_events.clear();
+
+        // Every piece is at `now`; level-of-detail blocks start over
+        launch_particles(particles.active.data(), particles.active.size(),
+                         now);
+        lod_blocks.clear();
+        lod_active_size = 0;
+    }
+}
+
+void clear_simulation()
+{
+    particles.clear();
+    flight_events.clear();
+    lod_blocks.clear();
+    lod_active_size = 0;
+}
+
+// Record a landing or sideways exit of airborne piece i, which has just
+// been stepped; true if it leaves the air
+static bool leaves_flight(const StepFrame &f, u32 i, TransitionBuffer &out)
+{
+    float *pos_x = particles.pos_x.data();
+    float *pos_y = particles.pos_y.data();
+    float *vel_x = particles.vel_x.data();
+    float *vel_y = particles.vel_y.data();
+    const float bbox_radius = f.bbox_radius;
+
+    if (pos_y[i] + bbox_radius > world_height)
+    {
+        vel_x[i] = 0.0f;
+        vel_y[i] = 0.0f;
+        pos_y[i] =
+            std::clamp(pos_y[i], bbox_radius, world_height - bbox_radius);
+        out.to_settle.push_back(i);
+        return true;
+    }
+
+    if (pos_x[i] + bbox_radius < 0 || pos_x[i] - bbox_radius > world_width)
+    {
+        // Defer erase until after the step to keep indices stable
+        out.to_release.push_back(i);
+        return true;
+    }
+
+    // Drag decays drifting sideways geometrically; flushed before it
+    // reaches subnormal floats, which are far slower to compute
+    if (std::abs(vel_x[i]) < MIN_DRIFT_SPEED)
+        vel_x[i] = 0.0f;
+    return false;
+}
+
+// Update airborne particles active[begin, end); landings and exits are
+// recorded in `out` and applied after all ranges have finished
+static void update_active_range(const StepFrame &f, size_t begin, size_t end,
+                                TransitionBuffer &out, WorkerScratch &scratch)
+{
+    const u32 *active = particles.active.data();
+    float *pos_x = particles.pos_x.data();
+    float *pos_y = particles.pos_y.data();
+    float *vel_x = particles.vel_x.data();
+    float *vel_y = particles.vel_y.data();
+    const float *spawn_time = particles.spawn_time.data();
+
+    const float dt = f.dt;
+    const double current_time = f.current_time;
+
+    // ---------- mouse ----------
+    // The push only adds a velocity change that depends on the position at
+    // the start of the step, so it is collected here and applied after the
+    // vector kernel: v += dv, pos += dv * dt gives the same result as adding
+    // dv between gravity and the position update
+    scratch.candidates.clear();
+    scratch.pushes.clear();
+    for (size_t n = begin; !f.mouse->empty() && n < end; ++n)
+    {
+        const u32 i = active[n];
+        if (spawn_time[i] + 1.f < current_time &&
+            f.mouse->mayContain(pos_x[i], pos_y[i]))
+            scratch.candidates.add(i, pos_x[i], pos_y[i]);
+    }
+    mouse_push_path(*f.mouse, scratch.candidates, scratch.path_scratch,
+                    scratch.pushes);
+
+    // ---------- drag, gravity, force fields, position ----------
+    integrate_particles(active + begin, end - begin, pos_x, pos_y, vel_x,
+                        vel_y, particles.k.data(), dt, f.gravity_dv, f.field);
+
+    for (const MousePush &push : scratch.pushes)
+    {
+        vel_x[push.index] += push.dvx;
+        vel_y[push.index] += push.dvy;
+        pos_x[push.index] += push.dvx * dt;
+        pos_y[push.index] += push.dvy * dt;
+    }
+
+    // ---------- bounds ----------
+    for (size_t n = begin; n < end; ++n)
+        leaves_flight(f, active[n], out);
+}
+
+// Level-of-detail counterpart of update_active_range: only the blocks due
+// this step are stepped, each from its own time to now in one long step,
+// and re-tiered (see set_lod_enabled). Landings and exits are recorded in
+// `out` as before.
+static void update_lod_range(const StepFrame &f, size_t begin, size_t end,
+                             TransitionBuffer &out, WorkerScratch &scratch)
+{
+    const u32 *active = particles.active.data();
+    float *pos_x = particles.pos_x.data();
+    float *pos_y = particles.pos_y.data();
+    float *vel_x = particles.vel_x.data();
+    float *vel_y = particles.vel_y.data();
+    const float *k = particles.k.data();
+    const float *spawn_time = particles.spawn_time.data();
+    float *launch_time = particles.launch_time.data();
+
+    const float dt = f.dt;
+    const double current_time = f.current_time;
+    const float now = since_launch_origin(current_time);
+    const float tolerance = 0.25f * dt;
+    const MousePath &mouse = *f.mouse;
+
+    // ---------- due blocks and mouse ----------
+    // A block is due on the steps of its tier, when forced, or when the
+    // mouse may reach it; only pieces of due blocks are pushed
+    scratch.due_blocks.clear();
+    scratch.candidates.clear();
+    scratch.pushes.clear();
+    for (size_t b = begin / LOD_BLOCK; b * LOD_BLOCK < end; ++b)
+    {
+        const LodBlock &block = lod_blocks[b];
+        const u64 period_mask = (u64{1} << block.tier) - 1;
+        const bool reachable =
+            !mouse.empty() && block.max_x >= mouse.min_x &&
+            block.min_x <= mouse.max_x && block.max_y >= mouse.min_y &&
+            block.min_y <= mouse.max_y;
+        if (!block.forced && !reachable && ((f.step + b) & period_mask) != 0)
+            continue;
+
+        scratch.due_blocks.push_back(static_cast<u32>(b));
+        const size_t last = std::min(end, (b + 1) * LOD_BLOCK);
+        out.stepped += last - b * LOD_BLOCK;
+        for (size_t n = b * LOD_BLOCK; !mouse.empty() && n < last; ++n)
+        {
+            const u32 i = active[n];
+            if (spawn_time[i] + 1.f < current_time &&
+                mouse.mayContain(pos_x[i], pos_y[i]))
+                scratch.candidates.add(i, pos_x[i], pos_y[i]);
+        }
+    }
+    mouse_push_path(mouse, scratch.candidates, scratch.path_scratch,
+                    scratch.pushes);
+
+    // ---------- drag, gravity, force fields, position ----------
+    for (const u32 b : scratch.due_blocks)
+    {
+        const size_t first = b * LOD_BLOCK;
+        const size_t last = std::min(end, first + LOD_BLOCK);
+        const LodBlock &block = lod_blocks[b];
+
+        // Pieces swapped in from other blocks carry their own time: they
+        // are stepped with the block, then put back and stepped alone
+        const float block_time = since_launch_origin(block.time);
+        scratch.stragglers.clear();
+        for (size_t n = first; n < last; ++n)
+        {
+            const u32 i = active[n];
+            if (std::abs(launch_time[i] - block_time) > tolerance)
+            {
+                scratch.stragglers.push_back({i, launch_time[i], pos_x[i],
+                                              pos_y[i], vel_x[i], vel_y[i]});
+            }
+        }
+
+        const double span = current_time - block.time;
+        if (span > 0.0)
+        {
+            const int steps =
+                std::max(1, static_cast<int>(std::lround(span / dt)));
+            const float long_dt = static_cast<float>(span);
+            integrate_particles(active + first, last - first, pos_x, pos_y,
+                                vel_x, vel_y, k, long_dt,
+                                gravity_gain(f.gravity, particles.drag,
+                                             long_dt / steps, steps),
+                                f.field);
+        }
+
+        for (const LodStraggler &straggler : scratch.stragglers)
+        {
+            const u32 i = straggler.index;
+            pos_x[i] = straggler.x;
+            pos_y[i] = straggler.y;
+            vel_x[i] = straggler.vx;
+            vel_y[i] = straggler.vy;
+            lod_advance(f, i, launch_origin + straggler.time);
+        }
+    }
+
+    for (const MousePush &push : scratch.pushes)
+    {
+        vel_x[push.index] += push.dvx;
+        vel_y[push.index] += push.dvy;
+        pos_x[push.index] += push.dvx * dt;
+        pos_y[push.index] += push.dvy * dt;
+    }
+
+    // ---------- bounds and tiers ----------
+    for (const u32 b : scratch.due_blocks)
+    {
+        const size_t first = b * LOD_BLOCK;
+        const size_t last = std::min(end, first + LOD_BLOCK);
+
+        float speed = 0.0f; // squared until the end
+        float accel = 0.0f;
+        float min_x = INFINITY, max_x = -INFINITY;
+        float min_y = INFINITY, max_y = -INFINITY;
+        for (size_t n = first; n < last; ++n)
+        {
+            const u32 i = active[n];
+            launch_time[i] = now;
+            if (leaves_flight(f, i, out))
+                continue;
+
+            // Drag and gravity; fields are added for the whole block
+            const float vx = vel_x[i];
+            const float vy = vel_y[i];
+            const float ax = -k[i] * vx;
+            const float ay = f.gravity - k[i] * vy;
+            speed = std::max(speed, vx * vx + vy * vy);
+            accel = std::max(accel, ax * ax + ay * ay);
+            min_x = std::min(min_x, pos_x[i]);
+            max_x = std::max(max_x, pos_x[i]);
+            min_y = std::min(min_y, pos_y[i]);
+            max_y = std::max(max_y, pos_y[i]);
+        }
+
+        LodBlock &block = lod_blocks[b];
+        block.time = current_time;
+        block.forced = 0;
+        lod_retier(f, block, std::sqrt(speed),
+                   std::sqrt(accel) + f.field_accel, min_x, max_x, min_y,
+                   max_y);
+    }
+}
+
+// Cheap test whether an analytic flight can come near the mouse at all: x
+// moves monotonically from x0 towards x0 + vx0 / k, and y never gets above
+// y0 + min(vy0, 0) / k, so most flights are rejected without an exp
+static bool flight_may_reach_mouse(const StepFrame &f, u32 i)
+{
+    const float k = particles.k[i];
+    if (k < TRAJECTORY_MIN_DRAG)
+        return true;
+
+    const float inv_k = 1.0f / k;
+    const float x0 = particles.pos_x[i];
+    const float x_end = x0 + particles.vel_x[i] * inv_k;
+    const float y_top = particles.pos_y[i] + std::min(particles.vel_y[i], 0.0f) *
+                                                 inv_k;
+
+    return std::max(x0, x_end) >= f.mouse->min_x &&
+           std::min(x0, x_end) <= f.mouse->max_x && y_top <= f.mouse->max_y;
+}
+
+// Analytic counterpart of update_active_range: positions are not stepped,
+// only particles hit by the mouse are re-launched. Their new flight ends are
+// queued after all ranges have finished; landings and exits come from the
+// event queue instead of a per-particle check.
+static void update_flight_range(const StepFrame &f, size_t begin, size_t end,
+                                TransitionBuffer &out, WorkerScratch &scratch)
+{
+    const u32 *active = particles.active.data();
+    const float *spawn_time = particles.spawn_time.data();
+    const double now = f.current_time;
+
+    scratch.candidates.clear();
+    scratch.pushes.clear();
+    for (size_t n = begin; n < end; ++n)
+    {
+        const u32 i = active[n];
+        if (spawn_time[i] + 1.f >= f.current_time ||
+            !flight_may_reach_mouse(f, i))
+            continue;
+
+        float x, y, vx, vy;
+        flight_state(i, now, x, y, vx, vy);
+        if (f.mouse->mayContain(x, y))
+            scratch.candidates.add(i, x, y);
+    }
+    mouse_push_path(*f.mouse, scratch.candidates, scratch.path_scratch,
+                    scratch.pushes);
+
+    // Re-launch the pushed pieces from their current state
+    for (const MousePush &push : scratch.pushes)
+    {
+        const u32 i = push.index;
+        float x, y, vx, vy;
+        flight_state(i, now, x, y, vx, vy);
+        particles.pos_x[i] = x;
+        particles.pos_y[i] = y;
+        particles.vel_x[i] = vx + push.dvx;
+        particles.vel_y[i] = vy + push.dvy;
+        particles.launch_time[i] = since_launch_origin(now);
+        out.relaunched.push_back(predict_flight_end(i));
+    }
+}
+
+// Land or drop every analytic flight whose predicted end has come. Only due
+// events are touched, so the cost follows the number of landings and exits
+// rather than the airborne population.
+static void process_flight_events(double now, float bbox_radius)
+{
+    float *pos_x = particles.pos_x.data();
+    float *pos_y = particles.pos_y.data();
+    float *vel_x = particles.vel_x.data();
+    float *vel_y = particles.vel_y.data();
+    const float floor_y = world_height - bbox_radius;
+    const auto stale = [](const obj::TimedEvent &event)
+    {
+        // Relaunched, settled or released since it was queued
+        return particles.list_id[event.index] != obj::LIST_ACTIVE ||
+               particles.flight[event.index] != event.flight;
+    };
+
+    while (flight_events.due(now))
+    {
+        const obj::TimedEvent event = flight_events.top();
+        flight_events.pop();
+        if (stale(event))
+            continue;
+
+        const u32 i = event.index;
+        if (!event.lands)
+        {
+            particles.release(i);
+            continue;
+        }
+
+        float x, y, vx, vy;
+        flight_state(i, event.time, x, y, vx, vy);
+        pos_x[i] = x;
+        pos_y[i] = floor_y;
+        vel_x[i] = 0.0f;
+        vel_y[i] = 0.0f;
+        particles.settle(i, static_cast<float>(now));
+    }
+
+    if (flight_events.size() > 2 * particles.active.size() + EVENT_SLACK)
+        flight_events.prune(stale);
+}
+
+void simulation_step(double dt, double current_time)
+{
+    if (!particles.settled.grid.configured())
+        particles.configure_grid(world_width, world_height,
+                                 SETTLED_CELL_SIZE);
+
+    // Launch times stay small enough for float precision however long the
+    // clock has run
+    if ((motion == MotionMode::Analytic || lod_on) &&
+        current_time - launch_origin > LAUNCH_ORIGIN_SPAN)
+        move_launch_origin(current_time);
+
+    const float bbox_radius = particles.radius;
+    take_mouse_path(bbox_radius, mouse_path);
+
+    // ---------- mouse: settled ----------
+    // Settled particles only change when the mouse reaches them, so each
+    // capsule of the path visits only the grid cells it overlaps, and the
+    // work follows the swept area. Candidates are archive record ids; a
+    // piece is pushed by the first capsule that reaches it.
+    const obj::SettledArchive &settled = particles.settled;
+    settled_pushes.clear();
+    for (size_t segment = 0; segment < mouse_path.capsules.size(); ++segment)
+    {
+        const MouseCapsule &capsule = mouse_path.capsules[segment];
+        settled_candidates.clear();
+        settled.grid.forEachNearSegment(
+            capsule.ax, capsule.ay, capsule.bx, capsule.by, capsule.radius,
+            [&](u32 id)
+            {
+                if (settled[id].spawn_time + 1.f < current_time &&
+                    (id >= settled_pushed.size() || !settled_pushed[id]))
+                    settled_candidates.add(id, settled.x(id), settled.y(id));
+            });
+
+        const size_t first = settled_pushes.size();
+        mouse_push_batch(capsule, settled_candidates, settled_pushes,
+                         static_cast<u16>(segment));
+        for (size_t h = first; h < settled_pushes.size(); ++h)
+        {
+            const u32 id = settled_pushes[h].index;
+            if (id >= settled_pushed.size())
+                settled_pushed.resize(id + 1, 0);
+            settled_pushed[id] = 1;
+        }
+    }
+    for (const MousePush &push : settled_pushes)
+        settled_pushed[push.index] = 0;
+
+    // Wake every piece the mouse reached (settled -> active, O(1) each)
+    const float now = static_cast<float>(current_time);
+    for (const MousePush &push : settled_pushes)
+    {
+        const u32 i = particles.wake(push.index, now);
+        if (i == obj::NO_PARTICLE)
+            continue;
+
+        particles.vel_x[i] += push.dvx;
+        particles.vel_y[i] += push.dvy;
+
+        // Pieces in front of the cursor are also flicked up a little
+        if (push.in_front)
+        {
+            // Keyed by step and particle, so the draw does not depend on
+            // the order pieces were found in
+            const MouseCapsule &mouse = mouse_path.capsules[push.segment];
+            float randFactor =
+                0.01f + 0.5f * counter_unit_float(random_engine.key(),
+                                                  FLICK_STREAM,
+                                                  (step_count << 32) | i);
+            float multi = mouse.speed * mouse.dt * MOUSE_MASS;
+
+            particles.vel_y[i] -= multi * randFactor;
+            particles.vel_x[i] += mouse.vx / mouse.speed * multi * 0.5f;
+        }
+
+        launch_particle(i, current_time);
+    }
+
+    // Flights in the air were predicted with the old gravity
+    const float gravity = gravity_acceleration();
+    if (motion == MotionMode::Analytic && gravity != launch_gravity)
+        relaunch_active(current_time, gravity);
+
+    // Fields are sampled by integrated flights only
+    if (motion == MotionMode::Integrated)
+        build_force_field(current_time);
+
+    StepFrame frame;
+    frame.dt = static_cast<float>(dt);
+    frame.current_time = current_time;
+    frame.bbox_radius = bbox_radius;
+    frame.gravity = gravity;
+    frame.gravity_dv = gravity * frame.dt;
+    frame.field = force_grid();
+    frame.mouse = &mouse_path;
+    frame.step = step_count;
+
+    const bool lod = motion == MotionMode::Integrated && lod_on;
+    frame.field_accel = lod && frame.field ? field_peak(*frame.field) : 0.0f;
+    if (lod)
+        lod_prepare_blocks();
+
+    // Update airborne particles: small counts inline, large counts in
+    // chunks across the job pool with one transition buffer per chunk
+    const auto update_range = motion == MotionMode::Analytic
+                                  ? update_flight_range
+                              : lod ? update_lod_range
+                                    : update_active_range;
+    const size_t active_count = particles.active.size();
+    size_t chunk_count = 1;
+    if (active_count < PARALLEL_THRESHOLD)
+    {
+        update_range(frame, 0, active_count, transitions[0],
+                     worker_scratch[0]);
+    }
+    else
+    {
+        JobPool &pool = physics_pool();
+        chunk_count = (active_count + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+        if (transitions.size() < chunk_count)
+            transitions.resize(chunk_count);
+        if (worker_scratch.size() < pool.size())
+            worker_scratch.resize(pool.size());
+
+        pool.parallelFor(active_count, PARALLEL_CHUNK,
+                         [&frame, update_range](size_t begin, size_t end,
+                                                unsigned worker)
+                         {
+                             update_range(frame, begin, end,
+                                          transitions[begin / PARALLEL_CHUNK],
+                                          worker_scratch[worker]);
+                         });
+    }
+
+    // Pieces this step advanced, for stepped_particles()
+    latest_step_count = motion == MotionMode::Analytic ? 0 : active_count;
+    if (lod)
+    {
+        latest_step_count = 0;
+        for (size_t c = 0; c < chunk_count; ++c)
+        {
+            latest_step_count += transitions[c].stepped;
+            transitions[c].stepped = 0;
+        }
+    }
+
+    // Merge the buffers in chunk order now that the active list is stable.
+    // All landings go before all exits, as in a single pass over the list,
+    // so slot reuse and archive order do not depend on the thread count.
+
+    // Archive the pieces that landed (active -> settled, O(1) each)
+    const float landed_at = static_cast<float>(current_time);
+    for (size_t c = 0; c < chunk_count; ++c)
+    {
+        TransitionBuffer &buffer = transitions[c];
+        for (u32 r : buffer.to_settle)
+        {
+            if (lod)
+                lod_note_removal(r, 0.25f * frame.dt);
+            particles.settle(r, landed_at);
+        }
+        buffer.to_settle.clear();
+    }
+
+    // Drop objects that left horizontal bounds from the active list
+    for (size_t c = 0; c < chunk_count; ++c)
+    {
+        TransitionBuffer &buffer = transitions[c];
+        for (u32 r : buffer.to_release)
+        {
+            if (lod)
+                lod_note_removal(r, 0.25f * frame.dt);
+            particles.release(r);
+        }
+        buffer.to_release.clear();
+    }
+
+    // Queue the flight ends re-predicted by the mouse
+    for (size_t c = 0; c < chunk_count; ++c)
+    {
+        TransitionBuffer &buffer = transitions[c];
+        for (const obj::TimedEvent &event : buffer.relaunched)
+        {
+            flight_events.push(event);
+        }
+        buffer.relaunched.clear();
+    }
+
+    if (motion == MotionMode::Analytic)
+        process_flight_events(current_time, bbox_radius);
+
+    lod_active_size = lod ? particles.active.size() : 0;
+    latest_step_time = current_time;
+    latest_step_dt = frame.dt;
+
+    update_fading_particles(current_time);
+    ++step_count;
+}
@@ -0,0 +1,277 @@
+#include "systems/simulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "entities/particles.h"
+#include "systems/job_pool.h"
+#include "systems/trajectory.h"
+#include "utils/globals.h"
+
+// ########## BULK SPAWN ##########
+
+// Pieces generated per pass; the per-chunk scratch stays in L1 and only the
+// particle arrays themselves stream through memory
+static constexpr size_t SPAWN_CHUNK = 256;
+
+// Batches at least this large are generated across the physics job pool,
+// in runs of SPAWN_PARALLEL_CHUNK pieces
+static constexpr size_t SPAWN_PARALLEL_THRESHOLD = 8192;
+static constexpr size_t SPAWN_PARALLEL_CHUNK = 4096;
+
+// Slots of the batch, reused across batches to avoid allocations
+static std::vector<u32> burst_index;
+
+// sin and cos of angles in [0, 4π) written without branches or calls so the
+// loop vectorizes: split off the nearest multiple q of π/2, evaluate both
+// Taylor polynomials on r in [-π/4, π/4] (error < 4e-7) and rotate the
+// result by q quarter turns with 0/1 and ±1 factors
+static void burst_sincos(const float *angle, size_t count, float *sin_out,
+                         float *cos_out)
+{
+    constexpr float HALF_PI = 1.57079632679f;
+    constexpr float INV_HALF_PI = 0.63661977236f;
+
+    for (size_t n = 0; n < count; ++n)
+    {
+        const int q = static_cast<int>(angle[n] * INV_HALF_PI + 0.5f);
+        const float r = angle[n] - static_cast<float>(q) * HALF_PI;
+        const float r2 = r * r;
+
+        const float s =
+            r * (1.0f +
+                 r2 * (-1.0f / 6.0f +
+                       r2 * (1.0f / 120.0f + r2 * (-1.0f / 5040.0f))));
+        const float c =
+            1.0f +
+            r2 * (-0.5f +
+                  r2 * (1.0f / 24.0f +
+                        r2 * (-1.0f / 720.0f + r2 * (1.0f / 40320.0f))));
+
+        // q = 0: (s, c), 1: (c, -s), 2: (-s, -c), 3: (-c, s)
+        const float swap = static_cast<float>(q & 1);
+        const float sin_sign = 1.0f - static_cast<float>(q & 2);
+        const float cos_sign = 1.0f - static_cast<float>((q + 1) & 2);
+        sin_out[n] = sin_sign * (s + swap * (c - s));
+        cos_out[n] = cos_sign * (c + swap * (s - c));
+    }
+}
+
+// What every chunk of one batch shares
+struct SpawnBatch
+{
+    const SpawnParams *params;
+    double time;
+    float k, g;
+    float angle_base, angle_step;
+    bool spread_out, along_line, staggered;
+
+    // Stream position of the batch's first draw, and draws per piece
+    u64 first_draw;
+    u32 draws;
+};
+
+// Generate and store pieces [begin, end) of the batch. Piece n draws
+// words first_draw + draws * n onwards, so any range can be made on any
+// thread and the batch comes out the same as in one pass.
+static void spawn_range(const SpawnBatch &batch, size_t begin, size_t end)
+{
+    const SpawnParams &params = *batch.params;
+    const float speed_range = params.speed_max - params.speed_min;
+    const float span_x = params.x1 - params.x0;
+    const float span_y = params.y1 - params.y0;
+    const float spawn_time = static_cast<float>(batch.time);
+
+    CounterRng rng(random_engine.key(), random_engine.stream());
+
+    // One Philox block (four words) per piece: word 0 holds the color,
+    // word 1 the speed variation, words 2 and 3 the four angles. Lines and
+    // areas take two more words per piece for the position.
+    u32 words[4 * SPAWN_CHUNK];
+    u32 place[2 * SPAWN_CHUNK];
+    float angle[SPAWN_CHUNK], speed[SPAWN_CHUNK];
+    float dir_x[SPAWN_CHUNK], dir_y[SPAWN_CHUNK];
+    float start_x[SPAWN_CHUNK], start_y[SPAWN_CHUNK];
+    float vel_x[SPAWN_CHUNK], vel_y[SPAWN_CHUNK], spawn[SPAWN_CHUNK];
+    u32 color[SPAWN_CHUNK];
+
+    for (size_t base = begin; base < end; base += SPAWN_CHUNK)
+    {
+        const size_t chunk = std::min(SPAWN_CHUNK, end - base);
+        rng.seek(batch.first_draw + batch.draws * base);
+        rng.fillU32(words, 4 * chunk);
+        if (batch.spread_out)
+            rng.fillU32(place, 2 * chunk);
+
+        // ---------- decode the draws (vectorizable) ----------
+        for (size_t j = 0; j < chunk; ++j)
+        {
+            angle[j] = batch.angle_base +
+                       static_cast<float>(words[4 * j + 3] >> 16) *
+                           batch.angle_step;
+            speed[j] = params.speed_min +
+                       speed_range * unit_float(words[4 * j + 1]);
+        }
+
+        if (!batch.spread_out)
+        {
+            std::fill(start_x, start_x + chunk, params.x0);
+            std::fill(start_y, start_y + chunk, params.y0);
+        }
+        else
+        {
+            // A line uses the first word for both axes
+            for (size_t j = 0; j < chunk; ++j)
+            {
+                const float u = unit_float(place[2 * j]);
+                const float v =
+                    batch.along_line ? u : unit_float(place[2 * j + 1]);
+                start_x[j] = params.x0 + span_x * u;
+                start_y[j] = params.y0 + span_y * v;
+            }
+        }
+
+        // ---------- launch in a random direction within the spread ----------
+        burst_sincos(angle, chunk, dir_y, dir_x);
+        for (size_t j = 0; j < chunk; ++j)
+        {
+            vel_x[j] = dir_x[j] * speed[j];
+            vel_y[j] = dir_y[j] * speed[j];
+            spawn[j] = spawn_time;
+            color[j] = words[4 * j] | pack_rgba8(0, 0, 0, 255);
+        }
+
+        // Staggered pieces have been flying since they left
+        for (size_t j = 0; batch.staggered && j < chunk; ++j)
+        {
+            const double left = params.first_time +
+                                static_cast<double>(base + j) * params.interval;
+            spawn[j] = static_cast<float>(left);
+            if (left < batch.time)
+            {
+                trajectory_at(start_x[j], start_y[j], vel_x[j], vel_y[j],
+                              batch.k, batch.g,
+                              static_cast<float>(batch.time - left),
+                              start_x[j], start_y[j], vel_x[j], vel_y[j]);
+            }
+        }
+
+        // ---------- scatter into the store ----------
+        // Slots the store grew by are consecutive; such a chunk is copied
+        // with plain stores, anything else is written slot by slot
+        const u32 *index = burst_index.data() + base;
+        bool consecutive = true;
+        for (size_t j = 0; j < chunk; ++j)
+            consecutive &= index[j] == index[0] + static_cast<u32>(j);
+
+        if (consecutive)
+        {
+            const u32 i = index[0];
+            std::copy_n(start_x, chunk, particles.pos_x.begin() + i);
+            std::copy_n(start_y, chunk, particles.pos_y.begin() + i);
+            std::copy_n(vel_x, chunk, particles.vel_x.begin() + i);
+            std::copy_n(vel_y, chunk, particles.vel_y.begin() + i);
+            std::fill_n(particles.k.begin() + i, chunk, batch.k);
+            std::copy_n(spawn, chunk, particles.spawn_time.begin() + i);
+            std::copy_n(color, chunk, particles.color.begin() + i);
+            // Rotation angles are stored as the drawn 16-bit turn fractions
+            u16 *pitch = particles.pitch.data() + i;
+            u16 *yaw = particles.yaw.data() + i;
+            u16 *roll = particles.roll.data() + i;
+            for (size_t j = 0; j < chunk; ++j)
+            {
+                pitch[j] = static_cast<u16>(words[4 * j + 2]);
+                yaw[j] = static_cast<u16>(words[4 * j + 2] >> 16);
+                roll[j] = static_cast<u16>(words[4 * j + 3]);
+            }
+            continue;
+        }
+
+        for (size_t j = 0; j < chunk; ++j)
+        {
+            const u32 i = index[j];
+            particles.pos_x[i] = start_x[j];
+            particles.pos_y[i] = start_y[j];
+            particles.vel_x[i] = vel_x[j];
+            particles.vel_y[i] = vel_y[j];
+            particles.k[i] = batch.k;
+            particles.spawn_time[i] = spawn[j];
+            particles.pitch[i] = static_cast<u16>(words[4 * j + 2]);
+            particles.yaw[i] = static_cast<u16>(words[4 * j + 2] >> 16);
+            particles.roll[i] = static_cast<u16>(words[4 * j + 3]);
+            particles.color[i] = color[j];
+        }
+    }
+}
+
+size_t spawn_pieces(const SpawnParams &params, size_t count, double time)
+{
+    // All confetti shares size and mass, so the bounding radius and drag
+    // constant are computed once per batch instead of once per piece
+    const float half_w = RECT_WIDTH * 0.5f;
+    const float half_h = RECT_HEIGHT * 0.5f;
+    particles.radius = std::sqrt(half_w * half_w + half_h * half_h);
+
+    const float area = RECT_SIM_WIDTH * RECT_SIM_HEIGHT * WORLD_TO_METERS *
+                       WORLD_TO_METERS;
+    SpawnBatch batch;
+    batch.params = &params;
+    batch.time = time;
+    batch.k = 0.5f * AIR_DENSITY * DRAG_COEFF * area / DEFAULT_MASS;
+    batch.g = gravity_acceleration();
+    particles.drag = batch.k;
+    particles.spin = ROTATION_SPEED;
+
+    // Evicts old confetti if the batch would exceed the particle budget,
+    // then takes every slot in one go
+    count = reserve_particles(count, time);
+    burst_index.resize(count);
+    count = particles.addBulk(count, burst_index.data());
+
+    // Angles start at the low edge of the spread, moved into [0, 2π) so
+    // every drawn angle is in the [0, 4π) burst_sincos handles
+    const float spread = std::min(std::max(params.spread, 0.0f), TWO_PI);
+    batch.angle_base = std::fmod(params.direction - 0.5f * spread, TWO_PI);
+    if (batch.angle_base < 0.0f)
+        batch.angle_base += TWO_PI;
+    batch.angle_step = spread / 65536.0f;
+
+    batch.spread_out = params.shape != SpawnParams::Shape::Point;
+    batch.along_line = params.shape == SpawnParams::Shape::Line;
+    batch.staggered = params.interval > 0.0;
+
+    // The batch takes its draws from the shared engine as one run
+    batch.first_draw = random_engine.position();
+    batch.draws = batch.spread_out ? 6 : 4;
+    random_engine.seek(batch.first_draw + batch.draws * count);
+
+    if (count < SPAWN_PARALLEL_THRESHOLD)
+    {
+        spawn_range(batch, 0, count);
+    }
+    else
+    {
+        physics_pool().parallelFor(
+            count, SPAWN_PARALLEL_CHUNK,
+            [&batch](size_t begin, size_t end, unsigned)
+            { spawn_range(batch, begin, end); });
+    }
+
+    launch_particles(burst_index.data(), count, time);
+
+    return count;
+}
+
+size_t spawn_burst(float x, float y, size_t count, double time)
+{
+    // Every direction, at the click explosion's strength and variation
+    SpawnParams params;
+    params.x0 = x;
+    params.y0 = y;
+    params.direction = 0.5f * TWO_PI;
+    params.spread = TWO_PI;
+    params.speed_min = EXPLOSION_STRENGTH + RANDOM_IMPULS_MIN;
+    params.speed_max = EXPLOSION_STRENGTH + RANDOM_IMPULS_MAX;
+    return spawn_pieces(params, count, time);
+}
@@ -1,5 +1,12 @@
 #include "utils/globals.h"
+
+#include <random>
+
 #include "entities/objects.h"
+#include "entities/particles.h"
+#include "systems/emitters.h"
+#include "systems/sim_thread.h"
+#include "systems/simulation.h"
 #include "utils/functions.h"
 
 // Forward declaration for ImFont
@@ -32,14 +39,11 @@ const float WORLD_TO_METERS =
     1.0f / METERS_TO_WORLD; // 0.01 meters per world unit
 
 // random number generation
-std::mt19937 random_engine(std::random_device{}());
-std::uniform_real_distribution<float> random_angle(0.0f, TWO_PI);
-std::uniform_real_distribution<float>
-    random_impuls_increase(-EXPLOSION_STRENGTH * 0.95f,
-                           EXPLOSION_STRENGTH * 0.5f);
-// std::uniform_real_distribution<float> random_impuls_increase(
-//     0.f,0.f
-// );
+CounterRng random_engine(std::random_device{}());
+const float RANDOM_IMPULS_MIN = -EXPLOSION_STRENGTH * 0.95f;
+const float RANDOM_IMPULS_MAX = EXPLOSION_STRENGTH * 0.5f;
+
+void seed_random(u64 seed) { random_engine.seed(seed); }
 
 // Graphics and rendering
 bool enable_vsync = true;
@@ -72,10 +76,15 @@ const float RECT_SIM_HEIGHT = 3.0f;
 // Rectangle storage and rendering layers
 // 0: background, 1: text, 2: rectangles
 std::vector<std::vector<obj::Rectangle *>> render_order(3);
-std::vector<std::unique_ptr<obj::Rectangle>> rectangles;
-std::vector<obj::Rectangle *> activeRects;
-std::vector<obj::Rectangle *> settledRects;
 int rectangle_count = 0;
+const u32 CLICK_SPAWN_COUNT = 200; // Number of rectangles spawned per click
+
+// Upper bound on live confetti, matches the renderer's instance buffer
+const u32 PARTICLE_CAPACITY = 1000000;
+// Default live limit that keeps a frame within budget on the target hardware
+const u32 PARTICLE_BUDGET = 300000;
+const float EVICTION_FADE = 0.5f;
+obj::ParticleStore particles(PARTICLE_CAPACITY);
 std::unique_ptr<obj::Rectangle> world_background = nullptr;
 
 size_t layer_background = 0;
@@ -92,16 +101,9 @@ float mouse_current_x = 0.0f;
 float mouse_current_y = 0.0f;
 float mouse_world_x = 0.0f;
 float mouse_world_y = 0.0f;
-float mouse_world_x_prev = 0.0f;
-float mouse_world_y_prev = 0.0f;
-float mouse_last_t = 0.0f;
 float mouse_current_t = 0.0f;
 double mouse_hold_duration = 0.0;
 
-// Performance tables
-std::vector<std::pair<float, float>> trig_table; // (sin, cos) pairs for angles
-size_t trig_table_size = 0;
-
 // ########## FONT SETIINGS ##########
 const char *TITLE_FONT_PATH = "assets/fonts/Rubik-BoldItalic.ttf";
 const float TITLE_FONT_SIZE = 150.0f; // Default font size in pixels
@@ -125,53 +127,17 @@ int title_height = 0;
 ImFont *g_DefaultFont = nullptr;
 ImFont *g_TitleFont = nullptr;
 
-// ########## TRIGONOMETRY OPTIMIZATION ##########
-
-void precompute_trig_angles()
-{
-    // Precompute sine and cosine values for 0 to 2π radians
-    // Using 0.001 rad increments for smooth interpolation
-    constexpr float ANGLE_INCREMENT = 0.001f;
-    const size_t num_angles = static_cast<size_t>(TWO_PI / ANGLE_INCREMENT) + 1;
-
-    trig_table.resize(num_angles);
-    for (size_t i = 0; i < num_angles; ++i)
-    {
-        float angle = i * ANGLE_INCREMENT;
-        trig_table[i] = std::make_pair(std::sin(angle), std::cos(angle));
-    }
-
-    trig_table_size = trig_table.size();
-}
-
-size_t angle_to_index(float angle)
-{
-    if (trig_table_size == 0)
-        return 0; // Safety check
-
-    // Normalize angle to [0, 2π) range
-    if (angle < 0)
-        angle += TWO_PI;
-
-    // Convert to table index
-    float normalized = angle * INV_TWO_PI;
-    size_t index = static_cast<size_t>(normalized *
-                                       static_cast<float>(trig_table_size - 1));
-
-    // Ensure index stays within bounds
-    return std::min(index, trig_table_size - 1);
-}
-
 // ########## RECTANGLE SPAWNING ##########
 
 void spawn_rectangles(float screen_x, float screen_y)
 {
-    std::vector<std::unique_ptr<obj::Rectangle>> new_rectangles;
-
     // Convert screen coordinates to world coordinates
-    float world_x = screen_to_world_x(screen_x);
-    float world_y = screen_to_world_y(screen_y);
+    spawn_rectangles_world(screen_to_world_x(screen_x),
+                           screen_to_world_y(screen_y));
+}
 
+void spawn_rectangles_world(float world_x, float world_y)
+{
     // Validate spawn position is within world bounds
     // if (world_x < 0.0f || world_x > world_width || world_y < 0.0f ||
     //     world_y > world_height)
@@ -179,69 +145,8 @@ void spawn_rectangles(float screen_x, float screen_y)
     //     return;
     // }
 
-    // Spawn configuration constants
-    constexpr int SPAWN_COUNT = 200; // Number of rectangles to spawn4
-
-    new_rectangles.reserve(SPAWN_COUNT);
-    rectangle_count += SPAWN_COUNT;
-
-    for (int i = 0; i < SPAWN_COUNT; ++i)
-    {
-        // Generate random color
-        Color<u8> color(rand() % 256, rand() % 256, rand() % 256, 255);
-
-        // Position rectangle center at click point (all start from the same
-        // point)
-        float initial_world_x = world_x - RECT_WIDTH / 2.0f;
-        float initial_world_y = world_y - RECT_HEIGHT / 2.0f;
-
-        // Create rectangle at click position
-        auto rect = std::make_unique<obj::Rectangle>(
-            initial_world_x, initial_world_y, RECT_WIDTH, RECT_HEIGHT, color);
-
-        // Configure rectangle properties
-        rect->should_rotate = true;
-        rect->move = true;
-        rect->spawn_time = static_cast<float>(glfwGetTime());
-        rect->randPhase =
-            random_angle(random_engine); // Random phase for flutter effect
-
-        // Set random initial rotation angles for GPU
-        rect->initial_pitch = TWO_PI * (static_cast<float>(rand()) / RAND_MAX);
-        rect->initial_yaw = TWO_PI * (static_cast<float>(rand()) / RAND_MAX);
-        rect->initial_roll = TWO_PI * (static_cast<float>(rand()) / RAND_MAX);
-
-        // === PHYSICS SETUP ===
-        // Set physics properties
-        rect->mass = DEFAULT_MASS;
-        rect->calcAirCalc();
-
-        // Apply initial explosive impulse in random direction
-        float explosion_angle =
-            random_angle(random_engine); // Random angle from 0 to 2π
-        float dir_x = std::cos(explosion_angle);
-        float dir_y = std::sin(explosion_angle);
-        obj::Vec2 impulse(dir_x, dir_y);
-        impulse.normalize();
-        float str = EXPLOSION_STRENGTH + random_impuls_increase(random_engine);
-        // std::cout<<"str: "<<str<<"\n";
-        impulse *= str;           // Scale to m/s
-        rect->velocity = impulse; // Scale by mass for consistent force
-
-        // NOTE: Legacy compatibility calls removed to avoid overriding physics
-        // The physics system now handles all movement
-
-        new_rectangles.push_back(std::move(rect));
-    }
-
-    // Add new rectangles to global storage and render order (layer 1)
-    for (auto &rect : new_rectangles)
-    {
-        obj::Rectangle *rect_ptr = rect.get();
-        rectangles.push_back(std::move(rect));
-        activeRects.push_back(rect_ptr); // Add to active rectangles
-        render_order[layer_rectangles].push_back(rect_ptr);
-    }
+    rectangle_count += static_cast<int>(
+        spawn_burst(world_x, world_y, CLICK_SPAWN_COUNT, simulation_time()));
 }
 
 // ########## MOUSE INPUT HANDLING ##########
@@ -262,27 +167,35 @@ void handle_mouse_hold_continuous()
 {
     constexpr double HOLD_THRESHOLD =
         0.5; // Start continuous spawn after 0.5 seconds
-    constexpr double SPAWN_INTERVAL =
-        0.1; // Spawn every 0.1 seconds during hold
-
-    static double last_spawn_time = 0.0;
 
-    if (left_mouse_held && mouse_hold_duration > HOLD_THRESHOLD)
+    // Only changes are sent, the emitter itself lives on the simulation side
+    static bool holding = false;
+    const bool hold = left_mouse_held && mouse_hold_duration > HOLD_THRESHOLD;
+    if (hold != holding)
     {
-        // Spawn rectangles continuously at intervals
-        if (mouse_hold_duration - last_spawn_time > SPAWN_INTERVAL)
-        {
-            spawn_rectangles(mouse_current_x, mouse_current_y);
-
-            last_spawn_time = mouse_hold_duration;
-        }
+        holding = hold;
+        post_simulation_input(SimInput::holdSpawn(hold));
     }
+}
+
+void set_hold_spawn(bool on)
+{
+    constexpr float HOLD_RATE =
+        2000.0f; // Pieces per second while held (a burst every 0.1 s before)
 
-    // Reset spawn timer when mouse is released
-    if (!left_mouse_held)
+    // Cursor emitter that spreads the hold spawn evenly over the frames;
+    // created paused on first use
+    static u32 hold_emitter = 0;
+    if (hold_emitter == 0)
     {
-        last_spawn_time = 0.0;
+        EmitterConfig config;
+        config.shape = EmitterShape::Cursor;
+        config.rate = HOLD_RATE;
+        config.enabled = false;
+        hold_emitter = add_emitter(config);
     }
+
+    set_emitter_enabled(hold_emitter, on);
 }
 
 // ########## WORLD COORDINATE SYSTEM ##########
@@ -331,6 +244,35 @@ void update_world_transform(float screen_w, float screen_h)
     // Update title layout when screen dimensions change
 }
 
+void remove_out_of_bounds_rectangles()
+{
+    // The physics step already releases confetti as it leaves the sides;
+    // this catches anything left outside after the world changes
+    const float r = particles.radius;
+    auto outside = [r](float x) { return x + r < 0 || x - r > world_width; };
+    const double now = simulation_time();
+
+    particles.settled.forEach(
+        [&](u32 id, const obj::SettledRecord &)
+        {
+            if (outside(particles.settled.x(id)))
+                particles.settled.remove(id);
+        });
+
+    for (const std::vector<u32> *list : {&particles.active, &particles.fading})
+    {
+        // Walk backwards, release() swaps the last entry into the slot
+        for (size_t n = list->size(); n-- > 0;)
+        {
+            const u32 i = (*list)[n];
+            float x, y, vx, vy;
+            particle_state_at(i, now, x, y, vx, vy);
+            if (outside(x))
+                particles.release(i);
+        }
+    }
+}
+
 // ########## TEXT RENDERING ##########
 
 void update_title_layout()
@@ -3,9 +3,50 @@
 #include <iostream>
 
 #include "entities/objects.h"    // Include full definition for Rectangle
+#include "entities/particles.h"
 #include "rendering/rasterize.h" // For update_viewport_cache
+#include "systems/force_field.h"
+#include "systems/sim_thread.h"
+#include "systems/simulation.h"
 #include "utils/key_captures.h"
 
+// The key commands below touch simulation state and run on the simulation
+// thread, posted as SimInput::run
+
+// Drop every piece of confetti
+static void clear_confetti()
+{
+    rectangle_count = 0;
+    clear_simulation();
+}
+
+static void toggle_gravity() { apply_gravity = !apply_gravity; }
+
+static void toggle_lod() { set_lod_enabled(!lod_enabled()); }
+
+// Toggle a light breeze: a steady wind plus turbulence over the whole world
+static void toggle_breeze()
+{
+    static u32 wind = 0;
+    static u32 gusts = 0;
+    if (wind != 0)
+    {
+        remove_force_field(wind);
+        remove_force_field(gusts);
+        wind = gusts = 0;
+        return;
+    }
+
+    FieldConfig config;
+    config.kind = FieldKind::Wind;
+    config.strength = 12.0f;
+    wind = add_force_field(config);
+
+    config.kind = FieldKind::Turbulence;
+    config.strength = 20.0f;
+    gusts = add_force_field(config);
+}
+
 // Key callback for GLFW
 void key_callback(GLFWwindow *window, int key, int scancode, int action,
                   int mods)
@@ -26,15 +67,18 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action,
             glfwSwapInterval(enable_vsync);
             break;
         case GLFW_KEY_R:
-            activeRects.clear();
-            settledRects.clear();
-            rectangle_count = 0;
-            rectangles.clear();
+            post_simulation_input(SimInput::run(clear_confetti));
             render_order[0].clear();
             // Re-add background rectangle
             break;
         case GLFW_KEY_G:
-            apply_gravity = !apply_gravity;
+            post_simulation_input(SimInput::run(toggle_gravity));
+            break;
+        case GLFW_KEY_F:
+            post_simulation_input(SimInput::run(toggle_breeze));
+            break;
+        case GLFW_KEY_L:
+            post_simulation_input(SimInput::run(toggle_lod));
             break;
         }
     }
@@ -58,7 +102,9 @@ void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
                       << ", " << mouse_current_y << ")" << std::endl;
 
             // Immediate click behavior - use already tracked mouse position
-            spawn_rectangles(mouse_current_x, mouse_current_y);
+            post_simulation_input(SimInput::burst(
+                screen_to_world_x(mouse_current_x),
+                screen_to_world_y(mouse_current_y), CLICK_SPAWN_COUNT));
             break;
         }
 
@@ -125,16 +171,15 @@ void mouse_position_callback(GLFWwindow *window, double xpos, double ypos)
     mouse_current_x = static_cast<float>(xpos);
     mouse_current_y = static_cast<float>(ypos);
 
-    mouse_world_x_prev = mouse_world_x;
-    mouse_world_y_prev = mouse_world_y;
-
     // Convert to world coordinates
     mouse_world_x = screen_to_world_x(mouse_current_x);
     mouse_world_y = screen_to_world_y(mouse_current_y);
-
-    mouse_last_t = mouse_current_t;
     mouse_current_t = glfwGetTime();
 
+    // Every event is part of this frame's cursor path
+    post_simulation_input(
+        SimInput::mouseSample(mouse_world_x, mouse_world_y, mouse_current_t));
+
     // Optional: Add drag behavior here if needed
     // if (is_mouse_dragging()) {
     //     // Handle drag behavior
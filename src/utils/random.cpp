@@ -0,0 +1,167 @@
+#include "utils/random.h"
+
+#include <algorithm>
+
+#include "systems/integrate.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||             \
+    defined(_M_IX86)
+#define SIM_X86 1
+#include <emmintrin.h>
+#endif
+
+// Defined in random_avx2.cpp, which is built with AVX2 enabled
+#ifdef SIM_X86
+size_t philox_fill_avx2(u32 *out, u64 first, size_t blocks, u64 stream,
+                        u64 key);
+#endif
+
+// ########## SCALAR REFERENCE ##########
+
+static void philox_fill_scalar(u32 *out, u64 first, size_t blocks, u64 stream,
+                               u64 key)
+{
+    for (size_t b = 0; b < blocks; ++b, out += 4)
+    {
+        const PhiloxBlock r = philox4x32(first + b, stream, key);
+        out[0] = r[0];
+        out[1] = r[1];
+        out[2] = r[2];
+        out[3] = r[3];
+    }
+}
+
+// ########## SSE2 (4 lanes) ##########
+
+#ifdef SIM_X86
+
+// Low and high halves of the 32x32 bit products a * m, per lane.
+// _mm_mul_epu32 only multiplies the even lanes, so the odd ones are shifted
+// down for a second multiply; the shuffles gather the halves back in lane
+// order.
+static inline void mulhilo_sse2(__m128i a, __m128i m, __m128i &lo,
+                                __m128i &hi)
+{
+    const __m128i even = _mm_shuffle_epi32(_mm_mul_epu32(a, m),
+                                           _MM_SHUFFLE(3, 1, 2, 0));
+    const __m128i odd = _mm_shuffle_epi32(
+        _mm_mul_epu32(_mm_srli_epi64(a, 32), m), _MM_SHUFFLE(3, 1, 2, 0));
+    lo = _mm_unpacklo_epi32(even, odd);
+    hi = _mm_unpackhi_epi32(even, odd);
+}
+
+// Counters first .. first + 3 split into low and high words. The low words
+// only carry into the high ones when they wrap within these four.
+static inline void counters_sse2(u64 first, __m128i &lo, __m128i &hi)
+{
+    const u32 first_lo = static_cast<u32>(first);
+    const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+    lo = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(first_lo)), lanes);
+    hi = _mm_set1_epi32(static_cast<int>(first >> 32));
+    if (first_lo > 0xFFFFFFFFu - 3)
+    {
+        const __m128i wrapped = _mm_cmpgt_epi32(
+            lanes, _mm_set1_epi32(static_cast<int>(0xFFFFFFFFu - first_lo)));
+        hi = _mm_sub_epi32(hi, wrapped);
+    }
+}
+
+// Writes the four blocks held one per lane in c0..c3 one after the other
+static inline void store_blocks_sse2(u32 *out, __m128i c0, __m128i c1,
+                                     __m128i c2, __m128i c3)
+{
+    const __m128i t0 = _mm_unpacklo_epi32(c0, c1);
+    const __m128i t1 = _mm_unpackhi_epi32(c0, c1);
+    const __m128i t2 = _mm_unpacklo_epi32(c2, c3);
+    const __m128i t3 = _mm_unpackhi_epi32(c2, c3);
+    __m128i *dst = reinterpret_cast<__m128i *>(out);
+    _mm_storeu_si128(dst + 0, _mm_unpacklo_epi64(t0, t2));
+    _mm_storeu_si128(dst + 1, _mm_unpackhi_epi64(t0, t2));
+    _mm_storeu_si128(dst + 2, _mm_unpacklo_epi64(t1, t3));
+    _mm_storeu_si128(dst + 3, _mm_unpackhi_epi64(t1, t3));
+}
+
+// Eight blocks per pass, one per lane of two interleaved groups of four so
+// the multiplies of one group overlap the other's: the counter words vary by
+// lane, the stream and key words are the same in all of them. Returns the
+// number of blocks done; the caller finishes the rest.
+static size_t philox_fill_sse2(u32 *out, u64 first, size_t blocks, u64 stream,
+                               u64 key)
+{
+    const __m128i m0 = _mm_set1_epi32(static_cast<int>(0xD2511F53u));
+    const __m128i m1 = _mm_set1_epi32(static_cast<int>(0xCD9E8D57u));
+    const __m128i stream_lo = _mm_set1_epi32(static_cast<int>(stream));
+    const __m128i stream_hi = _mm_set1_epi32(static_cast<int>(stream >> 32));
+
+    size_t b = 0;
+    for (; b + 8 <= blocks; b += 8, out += 32)
+    {
+        __m128i a0, a1, d0, d1;
+        counters_sse2(first + b, a0, a1);
+        counters_sse2(first + b + 4, d0, d1);
+        __m128i a2 = stream_lo, a3 = stream_hi;
+        __m128i d2 = stream_lo, d3 = stream_hi;
+        u32 k0 = static_cast<u32>(key);
+        u32 k1 = static_cast<u32>(key >> 32);
+
+        for (int round = 0; round < 10; ++round)
+        {
+            const __m128i key0 = _mm_set1_epi32(static_cast<int>(k0));
+            const __m128i key1 = _mm_set1_epi32(static_cast<int>(k1));
+            __m128i lo0, hi0, lo1, hi1, lo2, hi2, lo3, hi3;
+            mulhilo_sse2(a0, m0, lo0, hi0);
+            mulhilo_sse2(a2, m1, lo1, hi1);
+            mulhilo_sse2(d0, m0, lo2, hi2);
+            mulhilo_sse2(d2, m1, lo3, hi3);
+            a0 = _mm_xor_si128(_mm_xor_si128(hi1, a1), key0);
+            a2 = _mm_xor_si128(_mm_xor_si128(hi0, a3), key1);
+            a1 = lo1;
+            a3 = lo0;
+            d0 = _mm_xor_si128(_mm_xor_si128(hi3, d1), key0);
+            d2 = _mm_xor_si128(_mm_xor_si128(hi2, d3), key1);
+            d1 = lo3;
+            d3 = lo2;
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+
+        store_blocks_sse2(out, a0, a1, a2, a3);
+        store_blocks_sse2(out + 16, d0, d1, d2, d3);
+    }
+    return b;
+}
+
+#endif // SIM_X86
+
+// ########## DISPATCH ##########
+
+static SimdLevel active_backend = detect_simd_level();
+
+void set_philox_backend(SimdLevel level)
+{
+    active_backend = std::min(level, detect_simd_level());
+}
+
+SimdLevel philox_backend() { return active_backend; }
+
+void philox_fill(u32 *out, u64 first, size_t blocks, u64 stream, u64 key)
+{
+    size_t done = 0;
+    switch (active_backend)
+    {
+#ifdef SIM_X86
+    case SimdLevel::AVX2:
+        done = philox_fill_avx2(out, first, blocks, stream, key);
+        break;
+    case SimdLevel::SSE2:
+        done = philox_fill_sse2(out, first, blocks, stream, key);
+        break;
+#endif
+    default:
+        break;
+    }
+
+    // Tail
+    philox_fill_scalar(out + 4 * done, first + done, blocks - done, stream,
+                       key);
+}
@@ -0,0 +1,113 @@
+// AVX2 backend of philox_fill (8 lanes). This file is built with AVX2 code
+// generation enabled and is only called after the runtime check in
+// detect_simd_level().
+
+#include "utils/random.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||             \
+    defined(_M_IX86)
+
+#include <immintrin.h>
+
+// Low and high halves of the 32x32 bit products a * m, per lane; see
+// mulhilo_sse2
+static inline void mulhilo_avx2(__m256i a, __m256i m, __m256i &lo,
+                                __m256i &hi)
+{
+    const __m256i even = _mm256_mul_epu32(a, m);
+    const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+    lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+    hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+// Counters first .. first + 7 split into low and high words. The low words
+// only carry into the high ones when they wrap within these eight.
+static inline void counters_avx2(u64 first, __m256i &lo, __m256i &hi)
+{
+    const u32 first_lo = static_cast<u32>(first);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    lo = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(first_lo)),
+                          lanes);
+    hi = _mm256_set1_epi32(static_cast<int>(first >> 32));
+    if (first_lo > 0xFFFFFFFFu - 7)
+    {
+        const __m256i wrapped = _mm256_cmpgt_epi32(
+            lanes,
+            _mm256_set1_epi32(static_cast<int>(0xFFFFFFFFu - first_lo)));
+        hi = _mm256_sub_epi32(hi, wrapped);
+    }
+}
+
+// Writes the eight blocks held one per lane in c0..c3 one after the other:
+// a transpose within each 128-bit half (blocks 0-3 low, 4-7 high), then a
+// regrouping of the halves
+static inline void store_blocks_avx2(u32 *out, __m256i c0, __m256i c1,
+                                     __m256i c2, __m256i c3)
+{
+    const __m256i t0 = _mm256_unpacklo_epi32(c0, c1);
+    const __m256i t1 = _mm256_unpackhi_epi32(c0, c1);
+    const __m256i t2 = _mm256_unpacklo_epi32(c2, c3);
+    const __m256i t3 = _mm256_unpackhi_epi32(c2, c3);
+    const __m256i b04 = _mm256_unpacklo_epi64(t0, t2);
+    const __m256i b15 = _mm256_unpackhi_epi64(t0, t2);
+    const __m256i b26 = _mm256_unpacklo_epi64(t1, t3);
+    const __m256i b37 = _mm256_unpackhi_epi64(t1, t3);
+
+    __m256i *dst = reinterpret_cast<__m256i *>(out);
+    _mm256_storeu_si256(dst + 0, _mm256_permute2x128_si256(b04, b15, 0x20));
+    _mm256_storeu_si256(dst + 1, _mm256_permute2x128_si256(b26, b37, 0x20));
+    _mm256_storeu_si256(dst + 2, _mm256_permute2x128_si256(b04, b15, 0x31));
+    _mm256_storeu_si256(dst + 3, _mm256_permute2x128_si256(b26, b37, 0x31));
+}
+
+// Sixteen blocks per pass, one per lane of two interleaved groups of eight
+// (see philox_fill_sse2). Returns the number of blocks done; the caller
+// finishes the rest.
+size_t philox_fill_avx2(u32 *out, u64 first, size_t blocks, u64 stream,
+                        u64 key)
+{
+    const __m256i m0 = _mm256_set1_epi32(static_cast<int>(0xD2511F53u));
+    const __m256i m1 = _mm256_set1_epi32(static_cast<int>(0xCD9E8D57u));
+    const __m256i stream_lo = _mm256_set1_epi32(static_cast<int>(stream));
+    const __m256i stream_hi =
+        _mm256_set1_epi32(static_cast<int>(stream >> 32));
+
+    size_t b = 0;
+    for (; b + 16 <= blocks; b += 16, out += 64)
+    {
+        __m256i a0, a1, d0, d1;
+        counters_avx2(first + b, a0, a1);
+        counters_avx2(first + b + 8, d0, d1);
+        __m256i a2 = stream_lo, a3 = stream_hi;
+        __m256i d2 = stream_lo, d3 = stream_hi;
+        u32 k0 = static_cast<u32>(key);
+        u32 k1 = static_cast<u32>(key >> 32);
+
+        for (int round = 0; round < 10; ++round)
+        {
+            const __m256i key0 = _mm256_set1_epi32(static_cast<int>(k0));
+            const __m256i key1 = _mm256_set1_epi32(static_cast<int>(k1));
+            __m256i lo0, hi0, lo1, hi1, lo2, hi2, lo3, hi3;
+            mulhilo_avx2(a0, m0, lo0, hi0);
+            mulhilo_avx2(a2, m1, lo1, hi1);
+            mulhilo_avx2(d0, m0, lo2, hi2);
+            mulhilo_avx2(d2, m1, lo3, hi3);
+            a0 = _mm256_xor_si256(_mm256_xor_si256(hi1, a1), key0);
+            a2 = _mm256_xor_si256(_mm256_xor_si256(hi0, a3), key1);
+            a1 = lo1;
+            a3 = lo0;
+            d0 = _mm256_xor_si256(_mm256_xor_si256(hi3, d1), key0);
+            d2 = _mm256_xor_si256(_mm256_xor_si256(hi2, d3), key1);
+            d1 = lo3;
+            d3 = lo2;
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+
+        store_blocks_avx2(out, a0, a1, a2, a3);
+        store_blocks_avx2(out + 32, d0, d1, d2, d3);
+    }
+    return b;
+}
+
+#endif
@@ -0,0 +1,890 @@
+// Headless simulation runner: steps the confetti physics without a window
+//
+// Usage: headless_sim [options]
+//   --frames N        number of frames to simulate        (default 3600)
+//   --dt S            fixed frame time in seconds         (default 1/60)
+//   --fixed-step S    step the physics with the fixed stepper at S seconds
+//                     per step, independent of --dt (0 = one step per frame)
+//   --max-substeps N  most fixed steps run per frame     (default 8)
+//   --hitch S         stall the clock for S seconds halfway through the run
+//   --start-time S    start the scripted clock at S seconds   (default 0)
+//   --burst-every N   spawn one burst every N frames      (default 6)
+//   --bursts N        stop spawning after N bursts        (default 500)
+//   --burst-size N    confetti pieces per burst           (default 200)
+//   --sweep           drag the mouse back and forth along the floor
+//   --mouse-samples N cursor samples per frame while sweeping (default 1)
+//   --threads N       physics workers, 0 = all hardware threads (default 0)
+//   --budget N        live particle budget, 0 = whole pool (default 300000)
+//   --fade S          fade-out of evicted particles in seconds (default 0.5)
+//   --analytic        closed-form flights instead of per-frame integration
+//   --no-lod          step every airborne piece every step instead of slow
+//                     blocks every 2nd or 4th
+//   --pipelined       run the simulation on its own thread, one frame ahead
+//                     of this one, which packs each snapshot like the
+//                     renderer and checks its retained settled copy against
+//                     the archive (non-zero on mismatch); uses the fixed
+//                     stepper (at --dt unless --fixed-step is given)
+//   --simd LEVEL      integration and random fill backend: scalar, sse2 or
+//                     avx2 (default best)
+//   --seed N          random seed for spawns and mouse flicks (default 12345)
+//   --emitter SPEC    add a continuous emitter, e.g. "line x0=0 y0=0
+//                     x1=720 y1=0 rate=5000 dir=90" (repeatable; see
+//                     systems/emitters.h for the format)
+//   --emitters FILE   add every emitter described in FILE
+//   --field SPEC      add a force field, e.g. "vortex x=360 y=240 radius=150
+//                     speed=80" (repeatable; see systems/force_field.h)
+//   --verify          check the SIMD integration backends against the scalar
+//                     reference, Philox against its known answers and the
+//                     SIMD fills against it, the trig tables against
+//                     std::sin/cos, the force field grid against its fields
+//                     and level-of-detail stepping against full-rate
+//                     stepping, then exit (non-zero on mismatch)
+//
+// Spawns are scripted from a fixed seed, and time comes from a scripted
+// clock (frame * dt), so runs are repeatable. simulation_step and spawning
+// (bursts and emitters) are timed separately; with --fixed-step the emitters
+// run inside the steps and are timed with them. The report gives particle
+// steps per second, nanoseconds per particle per step and the cost of
+// spawning, including its worst frame. Use --bursts 0 with emitters for a
+// sustained-load scenario.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "entities/particles.h"
+#include "rendering/instance_format.h"
+#include "systems/emitters.h"
+#include "systems/force_field.h"
+#include "systems/integrate.h"
+#include "systems/mouse_interaction.h"
+#include "systems/sim_thread.h"
+#include "systems/simulation.h"
+#include "utils/globals.h"
+#include "utils/trig_table.h"
+
+// Scripted clock, advanced by the runner
+static double scripted_time = 0.0;
+static double start_time = 0.0;
+static double scripted_clock() { return scripted_time; }
+
+// Bursts walk across the upper half of the world
+static float burst_x(int burst)
+{
+    return world_width * (0.1f + 0.8f * ((burst * 37) % 100) / 100.0f);
+}
+
+// The mouse sweeps the floor once every four seconds
+static float sweep_x(double t)
+{
+    const float phase = static_cast<float>(t) * TWO_PI * 0.25f;
+    return world_width * (0.5f + 0.45f * std::sin(phase));
+}
+
+// ########## KERNEL VERIFICATION ##########
+
+// Run every available integration backend against the scalar reference on
+// random particles, through both contiguous and shuffled index lists, with
+// and without a random force field, and report the largest relative error
+static bool verify_integration()
+{
+    constexpr size_t COUNT = 100003; // odd size to exercise the tails
+    constexpr int STEPS = 16;
+    constexpr float TOLERANCE = 1e-5f;
+
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> position(0.0f, 2000.0f);
+    std::uniform_real_distribution<float> velocity(-3000.0f, 3000.0f);
+    std::uniform_real_distribution<float> drag(0.0f, 40.0f);
+
+    std::vector<float> pos_x(COUNT), pos_y(COUNT), vel_x(COUNT), vel_y(COUNT);
+    std::vector<float> k(COUNT);
+    for (size_t i = 0; i < COUNT; ++i)
+    {
+        pos_x[i] = position(rng);
+        pos_y[i] = position(rng);
+        vel_x[i] = velocity(rng);
+        vel_y[i] = velocity(rng);
+        k[i] = drag(rng);
+    }
+
+    // 40x30 nodes 32 units apart: part of the particles lie off the grid
+    // and sample its edges
+    std::uniform_real_distribution<float> acceleration(-500.0f, 500.0f);
+    std::vector<float> field_ax(40 * 30), field_ay(40 * 30);
+    for (size_t n = 0; n < field_ax.size(); ++n)
+    {
+        field_ax[n] = acceleration(rng);
+        field_ay[n] = acceleration(rng);
+    }
+    const ForceGrid grid = {field_ax.data(), field_ay.data(), 40, 30,
+                            1.0f / 32.0f};
+
+    std::vector<u32> contiguous(COUNT);
+    std::iota(contiguous.begin(), contiguous.end(), 0u);
+    std::vector<u32> shuffled = contiguous;
+    std::shuffle(shuffled.begin(), shuffled.end(), rng);
+
+    const float dt = 1.0f / 60.0f;
+    const float gravity_dv = GRAVITY_ACCELERATION * (RECT_WIDTH + 1) * dt;
+
+    struct VerifyCase
+    {
+        const std::vector<u32> *indices;
+        const ForceGrid *field;
+    };
+    const VerifyCase cases[] = {{&contiguous, nullptr},
+                                {&shuffled, nullptr},
+                                {&contiguous, &grid},
+                                {&shuffled, &grid}};
+
+    const SimdLevel saved = integrate_backend();
+    bool ok = true;
+
+    for (int level = 0; level <= static_cast<int>(detect_simd_level());
+         ++level)
+    {
+        set_integrate_backend(static_cast<SimdLevel>(level));
+
+        for (const VerifyCase &test : cases)
+        {
+            const std::vector<u32> *indices = test.indices;
+            const ForceGrid *field = test.field;
+
+            // Every step starts both sides from the reference state, so the
+            // error is per step and does not compound
+            std::vector<float> rx = pos_x, ry = pos_y, rvx = vel_x,
+                               rvy = vel_y;
+            float max_error = 0.0f;
+
+            for (int step = 0; step < STEPS; ++step)
+            {
+                std::vector<float> tx = rx, ty = ry, tvx = rvx, tvy = rvy;
+
+                integrate_particles(indices->data(), COUNT, tx.data(),
+                                    ty.data(), tvx.data(), tvy.data(),
+                                    k.data(), dt, gravity_dv, field);
+
+                // Relative to the largest magnitude involved, so sums that
+                // cancel to near zero are not flagged
+                auto compare = [&](const std::vector<float> &before,
+                                   const std::vector<float> &ref,
+                                   const std::vector<float> &got)
+                {
+                    for (size_t i = 0; i < COUNT; ++i)
+                    {
+                        float scale = std::max({1.0f, std::abs(ref[i]),
+                                                std::abs(before[i])});
+                        max_error = std::max(
+                            max_error, std::abs(got[i] - ref[i]) / scale);
+                    }
+                };
+
+                std::vector<float> bx = rx, by = ry, bvx = rvx, bvy = rvy;
+                integrate_particles_scalar(indices->data(), COUNT, rx.data(),
+                                           ry.data(), rvx.data(), rvy.data(),
+                                           k.data(), dt, gravity_dv, field);
+
+                compare(bx, rx, tx);
+                compare(by, ry, ty);
+                compare(bvx, rvx, tvx);
+                compare(bvy, rvy, tvy);
+            }
+
+            bool passed = max_error <= TOLERANCE;
+            ok = ok && passed;
+            std::cout << "  " << simd_level_name(integrate_backend())
+                      << (indices == &contiguous ? " contiguous" : " shuffled")
+                      << (field ? " + field" : "")
+                      << ": max rel error " << max_error
+                      << (passed ? "  ok" : "  FAILED") << std::endl;
+        }
+    }
+
+    set_integrate_backend(saved);
+    return ok;
+}
+
+// Philox4x32-10 against the published known-answer vectors (Random123's
+// kat_vectors), then every philox_fill backend against the scalar blocks,
+// across a carry into the counter's high word and with a scalar tail, and
+// CounterRng's fills against its next calls
+static bool verify_random()
+{
+    struct KnownAnswer
+    {
+        u64 counter, stream, key;
+        PhiloxBlock expected;
+    };
+    const KnownAnswer answers[] = {
+        {0, 0, 0, {0x6627E8D5u, 0xE169C58Du, 0xBC57AC4Cu, 0x9B00DBD8u}},
+        {~0ull,
+         ~0ull,
+         ~0ull,
+         {0x408F276Du, 0x41C83B0Eu, 0xA20BC7C6u, 0x6D5451FDu}},
+        {0x85A308D3243F6A88ull,
+         0x0370734413198A2Eull,
+         0x299F31D0A4093822ull,
+         {0xD16CFE09u, 0x94FDCCEBu, 0x5001E420u, 0x24126EA1u}}};
+
+    bool known_ok = true;
+    for (const KnownAnswer &answer : answers)
+    {
+        known_ok = known_ok && philox4x32(answer.counter, answer.stream,
+                                          answer.key) == answer.expected;
+    }
+    std::cout << "  known answers: " << (known_ok ? "match  ok" : "FAILED")
+              << std::endl;
+
+    constexpr size_t BLOCKS = 1003; // odd count to exercise the tails
+    constexpr u64 FIRST = 0xFFFFFFFFull - 500;
+    constexpr u64 STREAM = 0x0123456789ABCDEFull;
+    constexpr u64 KEY = 12345;
+
+    std::vector<u32> reference(4 * BLOCKS);
+    for (size_t b = 0; b < BLOCKS; ++b)
+    {
+        const PhiloxBlock r = philox4x32(FIRST + b, STREAM, KEY);
+        std::copy(r.begin(), r.end(), reference.begin() + 4 * b);
+    }
+
+    std::vector<u32> sequence(4 * BLOCKS);
+    CounterRng sequential(KEY, STREAM);
+    for (u32 &word : sequence)
+        word = sequential.nextU32();
+
+    const SimdLevel saved = philox_backend();
+    bool ok = known_ok;
+
+    for (int level = 0; level <= static_cast<int>(detect_simd_level());
+         ++level)
+    {
+        set_philox_backend(static_cast<SimdLevel>(level));
+
+        std::vector<u32> blocks(4 * BLOCKS);
+        philox_fill(blocks.data(), FIRST, BLOCKS, STREAM, KEY);
+        const bool fill_ok = blocks == reference;
+
+        // Fills of uneven lengths, starting mid-block
+        std::vector<u32> filled(4 * BLOCKS);
+        CounterRng rng(KEY, STREAM);
+        size_t n = 0;
+        for (size_t len = 1; n < filled.size(); len = len * 3 + 1)
+        {
+            const size_t chunk = std::min(len, filled.size() - n);
+            rng.fillU32(filled.data() + n, chunk);
+            n += chunk;
+        }
+        const bool rng_ok = filled == sequence;
+
+        const bool passed = fill_ok && rng_ok;
+        ok = ok && passed;
+        std::cout << "  " << simd_level_name(philox_backend())
+                  << ": philox_fill "
+                  << (fill_ok ? "matches scalar" : "differs")
+                  << ", fillU32 "
+                  << (rng_ok ? "matches nextU32" : "differs")
+                  << (passed ? "  ok" : "  FAILED") << std::endl;
+    }
+
+    set_philox_backend(saved);
+    return ok;
+}
+
+// Compare the compile-time trig and rotation tables with std::sin/cos over
+// angles spanning many turns in both directions. A lookup may be off by at
+// most half a table step plus float rounding.
+static bool verify_trig_tables()
+{
+    constexpr size_t COUNT = 100003;
+
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> turns(-1000.0f, 1000.0f);
+
+    std::vector<float> angle(COUNT), s(COUNT), c(COUNT);
+    for (float &a : angle)
+        a = turns(rng);
+    trig_lookup_batch(angle.data(), COUNT, s.data(), c.data());
+
+    float trig_error = 0.0f;
+    float mat_error = 0.0f;
+    bool batch_matches = true;
+    for (size_t n = 0; n < COUNT; ++n)
+    {
+        const double ref_s = std::sin(static_cast<double>(angle[n]));
+        const double ref_c = std::cos(static_cast<double>(angle[n]));
+
+        float one_s = 0.0f;
+        float one_c = 0.0f;
+        trig_lookup(angle[n], one_s, one_c);
+        batch_matches = batch_matches && one_s == s[n] && one_c == c[n];
+
+        trig_error = std::max({trig_error,
+                               static_cast<float>(std::abs(s[n] - ref_s)),
+                               static_cast<float>(std::abs(c[n] - ref_c))});
+
+        const Mat2 &m = rotation_matrix(angle[n]);
+        mat_error = std::max({mat_error,
+                              static_cast<float>(std::abs(m[0] - ref_c)),
+                              static_cast<float>(std::abs(m[2] - ref_s))});
+    }
+
+    // Half a step, plus the float rounding of angles up to 1000 turns
+    const float trig_tolerance = 0.5f / TRIG_INDEX_SCALE + 1e-4f;
+    const float mat_tolerance = 0.5f / MAT_INDEX_SCALE + 1e-4f;
+    const bool trig_ok = trig_error <= trig_tolerance;
+    const bool mat_ok = mat_error <= mat_tolerance;
+
+    std::cout << "  trig_table (" << TRIG_TABLE_SIZE << "): max abs error "
+              << trig_error << (trig_ok ? "  ok" : "  FAILED") << std::endl;
+    std::cout << "  batch lookup: "
+              << (batch_matches ? "matches scalar  ok" : "differs  FAILED")
+              << std::endl;
+    std::cout << "  mat_table (" << MAT_TABLE_SIZE << "): max abs error "
+              << mat_error << (mat_ok ? "  ok" : "  FAILED") << std::endl;
+    return trig_ok && mat_ok && batch_matches;
+}
+
+// Sample an attractor and a wind through the field grid: on a node the
+// sample is the field itself, between nodes the blend of its neighbours,
+// and outside the attractor's radius only the wind remains
+static bool verify_force_field()
+{
+    const float saved_drag = particles.drag;
+    particles.drag = 2.0f;
+
+    FieldConfig attractor;
+    attractor.kind = FieldKind::Attractor;
+    attractor.x = 352.0f;
+    attractor.y = 240.0f;
+    attractor.radius = 200.0f;
+    attractor.strength = 300.0f;
+
+    FieldConfig wind;
+    wind.kind = FieldKind::Wind;
+    wind.strength = 10.0f;
+    wind.direction = 0.25f * TWO_PI; // straight down
+
+    add_force_field(attractor);
+    add_force_field(wind);
+    build_force_field(0.0);
+
+    struct Probe
+    {
+        float x, y, ax, ay;
+    };
+    // 16-unit grid: 400 is a node, 408 halfway to the next one
+    const Probe probes[] = {
+        {400.0f, 240.0f, -300.0f * (1.0f - 48.0f / 200.0f), 20.0f},
+        {408.0f, 240.0f,
+         -150.0f * ((1.0f - 48.0f / 200.0f) + (1.0f - 64.0f / 200.0f)),
+         20.0f},
+        {40.0f, 40.0f, 0.0f, 20.0f},
+    };
+
+    float max_error = 0.0f;
+    for (const Probe &probe : probes)
+    {
+        float ax, ay;
+        sample_force_field(probe.x, probe.y, ax, ay);
+        max_error = std::max({max_error, std::abs(ax - probe.ax),
+                              std::abs(ay - probe.ay)});
+    }
+
+    clear_force_fields();
+    build_force_field(0.0);
+    particles.drag = saved_drag;
+
+    // The wind goes through the direction lookup table
+    const bool ok = max_error <= 0.01f;
+    std::cout << "  attractor + wind: max abs error " << max_error
+              << (ok ? "  ok" : "  FAILED") << std::endl;
+    return ok;
+}
+
+// Drop the same burst with and without level of detail and compare every
+// piece that is in the air in both runs once the slow blocks have caught
+// up. At the headless 1:1 zoom most of the burst drifts in slow blocks
+// well before the end.
+static bool verify_lod()
+{
+    constexpr int STEPS = 240;
+    constexpr double DT = 1.0 / 60.0;
+    constexpr size_t PIECES = 20000;
+
+    const bool saved = lod_enabled();
+    std::vector<float> x[2], y[2];
+    std::vector<u8> airborne[2];
+    size_t stepped = 0; // at the last step with LOD
+    for (int run = 0; run < 2; ++run)
+    {
+        clear_simulation();
+        set_lod_enabled(run == 1);
+        seed_random(7);
+        spawn_burst(world_width * 0.5f, world_height * 0.25f, PIECES, 0.0);
+        for (int s = 1; s <= STEPS; ++s)
+            simulation_step(DT, s * DT);
+
+        stepped = stepped_particles();
+        set_lod_enabled(false); // catches up
+        x[run] = particles.pos_x;
+        y[run] = particles.pos_y;
+        airborne[run].assign(particles.size(), 0);
+        for (u32 i : particles.active)
+            airborne[run][i] = 1;
+    }
+    clear_simulation();
+    set_lod_enabled(saved);
+
+    float max_error = 0.0f;
+    size_t compared = 0;
+    for (size_t i = 0; i < x[0].size() && i < x[1].size(); ++i)
+    {
+        if (!airborne[0][i] || !airborne[1][i])
+            continue;
+        max_error = std::max({max_error, std::abs(x[0][i] - x[1][i]),
+                              std::abs(y[0][i] - y[1][i])});
+        ++compared;
+    }
+
+    // Well under a pixel, with the slow blocks actually in use
+    const bool ok =
+        compared > PIECES / 2 && stepped < compared / 2 && max_error <= 0.25f;
+    std::cout << "  " << compared << " pieces, " << stepped
+              << " stepped at the end: max abs error " << max_error
+              << (ok ? "  ok" : "  FAILED") << std::endl;
+    return ok;
+}
+
+// ########## STATE HASH ##########
+
+// FNV-1a over the airborne pieces in list order and the settled records in
+// archive order. Equal across runs of the same scene only if every step came
+// out the same, including which slot and record each piece ended up in.
+static u64 state_hash()
+{
+    u64 hash = 0xCBF29CE484222325ull;
+    const auto mix = [&hash](const void *data, size_t size)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        for (size_t n = 0; n < size; ++n)
+            hash = (hash ^ bytes[n]) * 0x100000001B3ull;
+    };
+    for (u32 i : particles.active)
+    {
+        mix(&i, sizeof(i));
+        mix(&particles.pos_x[i], sizeof(float));
+        mix(&particles.pos_y[i], sizeof(float));
+        mix(&particles.vel_x[i], sizeof(float));
+        mix(&particles.vel_y[i], sizeof(float));
+    }
+    particles.settled.forEach([&mix](u32 id, const obj::SettledRecord &record)
+                              {
+                                  mix(&id, sizeof(id));
+                                  mix(&record, sizeof(record));
+                              });
+    return hash;
+}
+
+// ########## PIPELINED RUN ##########
+
+// The renderer's packing (rendering/instance_format.h), into the same
+// 32 byte instances. Flying pieces are packed every frame; settled ones are
+// kept one instance per archive slot, and only the slots a snapshot lists
+// as changed are repacked.
+struct PackedFrames
+{
+    std::vector<PackedInstance> flying;
+    std::vector<PackedInstance> settled;
+    size_t settled_packed = 0; // settled instances packed, all frames
+    size_t settled_drawn = 0;  // settled slots drawn, all frames
+};
+
+static void pack_snapshot(const SimSnapshot &frame, PackedFrames &out)
+{
+    const double epoch = instance_epoch(frame.render_time);
+    out.flying.resize(frame.flying());
+    for (size_t n = 0; n < frame.flying(); ++n)
+        pack_flying(frame, n, epoch, out.flying[n]);
+
+    out.settled.resize(frame.settled_slots);
+    const obj::SettledRecord *record = frame.settled_changes.data();
+    for (const obj::RecordRange &range : frame.settled_ranges)
+    {
+        for (u32 id = range.first; id < range.end; ++id)
+            out.settled[id] = pack_settled(*record++);
+    }
+    out.settled_packed += frame.settled_changes.size();
+    out.settled_drawn += frame.settled_slots;
+}
+
+// The same scripted frames as the serial loop in main(), but this thread
+// only posts the inputs, asks for the next frame and packs the previous
+// one while the simulation thread computes it. Frame f - 1 is waited for
+// before the clock moves to frame f, so every frame sees its own time.
+static bool run_pipelined(int frames, double dt, double hitch,
+                          int burst_every, int max_bursts, size_t burst_size,
+                          bool sweep, int mouse_samples)
+{
+    advance_simulation(); // starts the stepper's clock
+    start_simulation_thread();
+
+    PackedFrames packed;
+    double sim_seconds = 0.0;
+    double pack_seconds = 0.0;
+    int bursts = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame <= frames; ++frame)
+    {
+        wait_simulation_frame();
+        const SimSnapshot &previous = latest_snapshot();
+
+        if (frame < frames)
+        {
+            scripted_time = start_time + frame * dt +
+                            (frame >= frames / 2 ? hitch : 0.0);
+            if (frame % burst_every == 0 && bursts < max_bursts)
+            {
+                post_simulation_input(SimInput::burst(
+                    burst_x(bursts), world_height * 0.25f,
+                    static_cast<u32>(burst_size)));
+                ++bursts;
+            }
+            for (int s = mouse_samples - 1; sweep && s >= 0; --s)
+            {
+                const double t = scripted_time - dt * s / mouse_samples;
+                post_simulation_input(SimInput::mouseSample(
+                    sweep_x(t), world_height - MOUSE_RADIUS,
+                    static_cast<float>(t)));
+            }
+            request_simulation_frame();
+        }
+
+        if (previous.frame == 0)
+            continue;
+        const auto pack_start = std::chrono::steady_clock::now();
+        pack_snapshot(previous, packed);
+        pack_seconds += std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - pack_start)
+                            .count();
+        sim_seconds += previous.sim_seconds;
+    }
+    const double wall_seconds = std::chrono::duration<double>(
+                                    std::chrono::steady_clock::now() - start)
+                                    .count();
+    stop_simulation_thread();
+
+    // The settled instances kept from the changes alone must match the
+    // archive they mirror
+    const SimSnapshot &last = latest_snapshot();
+    const obj::SettledArchive &archive = particles.settled;
+    bool retained_ok = packed.settled.size() == archive.slots();
+    for (u32 id = 0; retained_ok && id < archive.slots(); ++id)
+    {
+        const PackedInstance instance = pack_settled(archive[id]);
+        retained_ok = std::memcmp(&instance, &packed.settled[id],
+                                  sizeof(instance)) == 0;
+    }
+
+    std::cout << "Frames:             " << frames << " (dt " << dt
+              << " s, pipelined)" << std::endl;
+    std::cout << "Fixed steps:        " << fixed_step() << " s, at most "
+              << max_substeps() << " per frame" << std::endl;
+    std::cout << "Physics threads:    " << simulation_threads() << std::endl;
+    std::cout << "Last snapshot:      " << last.flying() << " flying, "
+              << last.settled << " settled" << std::endl;
+    std::cout << "Settled repacked:   " << packed.settled_packed << " of "
+              << packed.settled_drawn << " instances drawn, retained copy "
+              << (retained_ok ? "matches" : "DIFFERS FROM") << " the archive"
+              << std::endl;
+    std::cout << "Simulation thread:  " << sim_seconds * 1000.0
+              << " ms (inputs, steps, snapshots)" << std::endl;
+    std::cout << "Packing:            " << pack_seconds * 1000.0 << " ms"
+              << std::endl;
+    std::cout << "Wall time:          " << wall_seconds * 1000.0
+              << " ms, serial would be "
+              << (sim_seconds + pack_seconds) * 1000.0 << " ms" << std::endl;
+    return retained_ok;
+}
+
+int main(int argc, char **argv)
+{
+    int frames = 3600;
+    double dt = 1.0 / 60.0;
+    double fixed_step_seconds = 0.0;
+    double hitch = 0.0;
+    int burst_every = 6;
+    int max_bursts = 500;
+    size_t burst_size = 200;
+    bool sweep = false;
+    int mouse_samples = 1;
+    bool verify = false;
+    bool analytic = false;
+    bool lod = true;
+    bool pipelined = false;
+    u64 seed = 12345;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--frames" && has_value)
+            frames = std::atoi(argv[++i]);
+        else if (arg == "--dt" && has_value)
+            dt = std::atof(argv[++i]);
+        else if (arg == "--fixed-step" && has_value)
+            fixed_step_seconds = std::atof(argv[++i]);
+        else if (arg == "--max-substeps" && has_value)
+            set_fixed_step(0.0, std::atoi(argv[++i]));
+        else if (arg == "--hitch" && has_value)
+            hitch = std::max(0.0, std::atof(argv[++i]));
+        else if (arg == "--start-time" && has_value)
+            start_time = std::max(0.0, std::atof(argv[++i]));
+        else if (arg == "--burst-every" && has_value)
+            burst_every = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--bursts" && has_value)
+            max_bursts = std::atoi(argv[++i]);
+        else if (arg == "--burst-size" && has_value)
+            burst_size = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--sweep")
+            sweep = true;
+        else if (arg == "--mouse-samples" && has_value)
+            mouse_samples = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && has_value)
+            set_simulation_threads(std::atoi(argv[++i]));
+        else if (arg == "--budget" && has_value)
+            set_particle_budget(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--fade" && has_value)
+            set_eviction_fade(std::atof(argv[++i]));
+        else if (arg == "--simd" && has_value)
+        {
+            std::string level = argv[++i];
+            SimdLevel simd;
+            if (level == "scalar")
+                simd = SimdLevel::Scalar;
+            else if (level == "sse2")
+                simd = SimdLevel::SSE2;
+            else if (level == "avx2")
+                simd = SimdLevel::AVX2;
+            else
+            {
+                std::cerr << "Unknown SIMD level: " << level << std::endl;
+                return 1;
+            }
+            set_integrate_backend(simd);
+            set_philox_backend(simd);
+        }
+        else if (arg == "--seed" && has_value)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--emitter" && has_value)
+        {
+            EmitterConfig config;
+            if (!parse_emitter_config(argv[++i], config))
+                return 1;
+            add_emitter(config);
+        }
+        else if (arg == "--emitters" && has_value)
+        {
+            if (load_emitters(argv[++i]) < 0)
+                return 1;
+        }
+        else if (arg == "--field" && has_value)
+        {
+            FieldConfig config;
+            if (!parse_field_config(argv[++i], config))
+                return 1;
+            add_force_field(config);
+        }
+        else if (arg == "--analytic")
+            analytic = true;
+        else if (arg == "--no-lod")
+            lod = false;
+        else if (arg == "--pipelined")
+            pipelined = true;
+        else if (arg == "--verify")
+            verify = true;
+        else
+        {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (verify)
+    {
+        std::cout << "Integration kernel vs scalar reference:" << std::endl;
+        const bool integration_ok = verify_integration();
+        std::cout << "Philox random numbers:" << std::endl;
+        const bool random_ok = verify_random();
+        std::cout << "Trig tables vs std::sin/cos:" << std::endl;
+        const bool trig_ok = verify_trig_tables();
+        std::cout << "Force field grid vs fields:" << std::endl;
+        const bool field_ok = verify_force_field();
+        std::cout << "Level of detail vs full rate:" << std::endl;
+        const bool lod_ok = verify_lod();
+        return integration_ok && random_ok && trig_ok && field_ok && lod_ok
+                   ? 0
+                   : 1;
+    }
+
+    scripted_time = start_time;
+    set_simulation_clock(scripted_clock);
+    set_lod_enabled(lod);
+    if (analytic)
+        set_motion_mode(MotionMode::Analytic);
+    seed_random(seed);
+
+    if (pipelined)
+    {
+        set_fixed_step(fixed_step_seconds > 0.0 ? fixed_step_seconds : dt, 0);
+        return run_pipelined(frames, dt, hitch, burst_every, max_bursts,
+                             burst_size, sweep, mouse_samples)
+                   ? 0
+                   : 1;
+    }
+
+    const bool fixed = fixed_step_seconds > 0.0;
+    if (fixed)
+    {
+        set_fixed_step(fixed_step_seconds, 0);
+        advance_simulation(); // starts the stepper's clock
+    }
+
+    double step_seconds = 0.0;
+    double spawn_seconds = 0.0;
+    double spawn_worst = 0.0; // slowest frame's spawning
+    size_t spawned = 0;
+    size_t emitted = 0;
+    double particle_steps = 0.0;
+    double airborne_steps = 0.0; // per-frame steps only
+    double stepped = 0.0;        // of those, pieces actually advanced
+    int bursts = 0;
+    int steps = 0;
+    double dropped = 0.0;
+
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        scripted_time =
+            start_time + frame * dt + (frame >= frames / 2 ? hitch : 0.0);
+        const double now = simulation_time();
+
+        auto spawn_start = std::chrono::steady_clock::now();
+
+        if (frame % burst_every == 0 && bursts < max_bursts)
+        {
+            spawned += spawn_burst(burst_x(bursts), world_height * 0.25f,
+                                   burst_size, now);
+            ++bursts;
+        }
+        if (!fixed)
+            emitted += update_emitters(now);
+
+        double spawn_frame = std::chrono::duration<double>(
+                                 std::chrono::steady_clock::now() -
+                                 spawn_start)
+                                 .count();
+        spawn_seconds += spawn_frame;
+        spawn_worst = std::max(spawn_worst, spawn_frame);
+
+        // The mouse reports its position `mouse_samples` times per frame
+        // like a fast pointer
+        if (sweep)
+        {
+            for (int s = mouse_samples - 1; s >= 0; --s)
+            {
+                const double t = now - dt * s / mouse_samples;
+                mouse_world_x = sweep_x(t);
+                mouse_world_y = world_height - MOUSE_RADIUS;
+                mouse_current_t = static_cast<float>(t);
+                record_mouse_sample(mouse_world_x, mouse_world_y,
+                                    mouse_current_t);
+                set_emitter_cursor(mouse_world_x, mouse_world_y);
+            }
+        }
+
+        const size_t population =
+            particles.active.size() + particles.settled.size();
+
+        auto start = std::chrono::steady_clock::now();
+        if (fixed)
+        {
+            const AdvanceResult advance = advance_simulation();
+            particle_steps += static_cast<double>(population) * advance.steps;
+            steps += advance.steps;
+            emitted += advance.emitted;
+            dropped += advance.dropped;
+        }
+        else
+        {
+            particle_steps += population;
+            airborne_steps += particles.active.size();
+            ++steps;
+            simulation_step(dt, now);
+            stepped += stepped_particles();
+        }
+        step_seconds += std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+    }
+
+    std::cout << "Frames:             " << frames << " (dt " << dt << " s)"
+              << std::endl;
+    if (fixed)
+        std::cout << "Fixed steps:        " << steps << " of "
+                  << fixed_step() << " s, at most " << max_substeps()
+                  << " per frame, " << dropped << " s dropped" << std::endl;
+    std::cout << "Physics threads:    " << simulation_threads() << std::endl;
+    std::cout << "Integration:        "
+              << (analytic ? "analytic"
+                           : simd_level_name(integrate_backend()))
+              << (lod && !analytic ? ", level of detail" : "") << std::endl;
+    if (lod && !analytic && airborne_steps > 0.0)
+        std::cout << "Stepped / airborne: "
+                  << 100.0 * stepped / airborne_steps << " %" << std::endl;
+    std::cout << "Live / capacity:    " << particles.live() << " / "
+              << particles.capacity() << " (" << particles.size()
+              << " slots used)" << std::endl;
+    std::cout << "Budget:             " << particle_budget() << std::endl;
+    if (force_field_count() > 0)
+        std::cout << "Force fields:       " << force_field_count()
+                  << std::endl;
+    std::cout << "Active / settled:   " << particles.active.size() << " / "
+              << particles.settled.size() << " (" << particles.fading.size()
+              << " fading)" << std::endl;
+    std::cout << "State hash:         " << std::hex << std::setw(16)
+              << std::setfill('0') << state_hash() << std::dec
+              << std::setfill(' ') << std::endl;
+    std::cout << "Simulation time:    " << step_seconds * 1000.0 << " ms"
+              << std::endl;
+
+    if (step_seconds > 0.0 && particle_steps > 0.0)
+    {
+        std::cout << "Particles/sec:      " << particle_steps / step_seconds
+                  << std::endl;
+        std::cout << "ns/particle/step:   "
+                  << step_seconds * 1e9 / particle_steps << std::endl;
+    }
+
+    std::cout << "Spawned:            " << spawned << " in " << bursts
+              << " bursts";
+    if (emitter_count() > 0)
+        std::cout << ", " << emitted << " from " << emitter_count()
+                  << " emitters";
+    std::cout << std::endl;
+    std::cout << "Spawn time:         " << spawn_seconds * 1000.0 << " ms";
+    if (bursts > 0)
+        std::cout << " (" << spawn_seconds * 1000.0 / bursts << " ms/burst)";
+    std::cout << ", worst frame " << spawn_worst * 1000.0 << " ms"
+              << std::endl;
+
+    return 0;
+}
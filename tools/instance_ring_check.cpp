@@ -0,0 +1,365 @@
+// Offscreen check of the instance ring (rendering/instance_ring.h)
+//
+// Usage: instance_ring_check [instances] [frames]
+//
+// Runs on any EGL driver with OpenGL 4.4, Mesa's software rasterizer
+// (llvmpipe) included: no window or display is needed.
+//
+// Correctness: every frame packs two layers into the ring, as the renderer
+// packs the background and the confetti, and draws each instance as one
+// point into a float texture, frame by frame into rows of their own. The
+// ring starts small, so the first frames grow it. Only after the last
+// frame is the texture read back: had the ring overwritten a region the GPU
+// still read, some frame would show another frame's values. (llvmpipe
+// fetches vertices when the draw is issued, so there this checks the
+// offsets, layers and growth; the overlap shows on drivers that do not.)
+//
+// Throughput: the same frames of `instances` instances of the renderer's
+// 32 byte packed layout, uploaded with glBufferSubData from a staging vector into
+// one buffer, then written straight into the ring.
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "rendering/instance_format.h"
+#include "rendering/instance_ring.h"
+
+using bench_clock = std::chrono::steady_clock;
+
+static double elapsed_ms(bench_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(bench_clock::now() -
+                                                     start)
+        .count();
+}
+
+// Same stride as the renderer's instances
+static constexpr size_t STRIDE = sizeof(PackedInstance);
+static constexpr size_t INSTANCE_FLOATS = STRIDE / sizeof(float);
+
+// Correctness target: one row block per frame
+static constexpr int TARGET_WIDTH = 1024;
+static constexpr int ROWS_PER_FRAME = 64;
+static constexpr int CHECK_FRAMES = 12;
+static constexpr size_t FRAME_PIXELS = size_t(TARGET_WIDTH) * ROWS_PER_FRAME;
+
+// ########## CONTEXT ##########
+
+static bool create_context()
+{
+    EGLDisplay display = EGL_NO_DISPLAY;
+    const auto get_platform_display =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (get_platform_display)
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                       EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major = 0, minor = 0;
+    if (!eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cerr << "Failed to initialize EGL" << std::endl;
+        return false;
+    }
+
+    const EGLint attributes[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                 4,
+                                 EGL_CONTEXT_MINOR_VERSION,
+                                 4,
+                                 EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                 EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                 EGL_NONE};
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR,
+                                          EGL_NO_CONTEXT, attributes);
+    if (context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+    {
+        std::cerr << "Failed to create an OpenGL 4.4 core context"
+                  << std::endl;
+        return false;
+    }
+
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)))
+    {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+    std::cout << "OpenGL " << glGetString(GL_VERSION) << " on "
+              << glGetString(GL_RENDERER) << std::endl;
+    return true;
+}
+
+// ########## POINT PROGRAM ##########
+
+// Instance i of a draw lands on pixel uFirst + i and writes the first float
+// of its instance data
+static const char *POINT_VERTEX_SHADER = R"(#version 440 core
+layout(location = 1) in float aValue;
+uniform int uFirst;
+uniform ivec2 uTarget;
+out float vValue;
+void main()
+{
+    int pixel = uFirst + gl_InstanceID;
+    vec2 cell = vec2(pixel % uTarget.x, pixel / uTarget.x) + 0.5;
+    gl_Position = vec4(cell / vec2(uTarget) * 2.0 - 1.0, 0.0, 1.0);
+    gl_PointSize = 1.0;
+    vValue = aValue;
+}
+)";
+
+static const char *POINT_FRAGMENT_SHADER = R"(#version 440 core
+in float vValue;
+out float FragValue;
+void main() { FragValue = vValue; }
+)";
+
+static GLuint compile(GLenum type, const char *source)
+{
+    const GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    GLint ok = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok)
+    {
+        char log[512];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cerr << "Shader compilation failed:\n" << log << std::endl;
+    }
+    return shader;
+}
+
+static GLuint point_program()
+{
+    const GLuint program = glCreateProgram();
+    const GLuint vertex = compile(GL_VERTEX_SHADER, POINT_VERTEX_SHADER);
+    const GLuint fragment = compile(GL_FRAGMENT_SHADER, POINT_FRAGMENT_SHADER);
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    return program;
+}
+
+// A VAO reading one float per instance from binding 1, like the renderer's
+static GLuint point_vao()
+{
+    GLuint vao = 0;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glVertexAttribFormat(1, 1, GL_FLOAT, GL_FALSE, 0);
+    glVertexAttribBinding(1, 1);
+    glEnableVertexAttribArray(1);
+    glVertexBindingDivisor(1, 1);
+    return vao;
+}
+
+static void draw_points(GLuint buffer, GLintptr offset, size_t count,
+                        int first, GLint first_location)
+{
+    glBindVertexBuffer(1, buffer, offset, STRIDE);
+    glUniform1i(first_location, first);
+    glDrawArraysInstanced(GL_POINTS, 0, 1, static_cast<GLsizei>(count));
+}
+
+// Fill `count` instances with their value: exact in a float for any frame
+// and index used here
+static float check_value(int frame, size_t index)
+{
+    return static_cast<float>((frame + 1) * 100000 + index);
+}
+
+static void fill(float *out, int frame, size_t first, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        out[0] = check_value(frame, first + i);
+        for (size_t f = 1; f < INSTANCE_FLOATS; ++f)
+            out[f] = 0.0f;
+        out += INSTANCE_FLOATS;
+    }
+}
+
+// ########## CORRECTNESS ##########
+
+static bool check_ring(GLuint program, GLuint vao)
+{
+    GLuint target = 0, framebuffer = 0;
+    const int height = ROWS_PER_FRAME * CHECK_FRAMES;
+    glGenTextures(1, &target);
+    glBindTexture(GL_TEXTURE_2D, target);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32F, TARGET_WIDTH, height);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, target, 0);
+    glViewport(0, 0, TARGET_WIDTH, height);
+    const float clear = -1.0f;
+    glClearBufferfv(GL_COLOR, 0, &clear);
+
+    glUseProgram(program);
+    glBindVertexArray(vao);
+    glUniform2i(glGetUniformLocation(program, "uTarget"), TARGET_WIDTH,
+                height);
+    const GLint first_location = glGetUniformLocation(program, "uFirst");
+
+    // Starts at 256 instances a frame, so the first frames grow the ring
+    InstanceRing ring;
+    if (!ring.create(STRIDE, 256, FRAME_PIXELS))
+        return false;
+
+    std::vector<size_t> counts(CHECK_FRAMES);
+    for (int frame = 0; frame < CHECK_FRAMES; ++frame)
+    {
+        // Two layers of varying sizes, the second one larger
+        const size_t count = FRAME_PIXELS / 2 + frame * 997 % 20000;
+        const size_t background = count / 8;
+        counts[frame] = count;
+        const int first_pixel = frame * static_cast<int>(FRAME_PIXELS);
+
+        ring.beginFrame();
+        const InstanceRing::Span back = ring.allocate(background);
+        fill(static_cast<float *>(back.data), frame, 0, back.count);
+        draw_points(ring.buffer(), back.offset, back.count, first_pixel,
+                    first_location);
+
+        const InstanceRing::Span front = ring.allocate(count - background);
+        fill(static_cast<float *>(front.data), frame, background, front.count);
+        draw_points(ring.buffer(), front.offset, front.count,
+                    first_pixel + static_cast<int>(background),
+                    first_location);
+        ring.endFrame();
+    }
+
+    std::vector<float> pixels(size_t(TARGET_WIDTH) * height);
+    glReadPixels(0, 0, TARGET_WIDTH, height, GL_RED, GL_FLOAT, pixels.data());
+
+    size_t wrong = 0;
+    for (int frame = 0; frame < CHECK_FRAMES; ++frame)
+    {
+        const float *row = pixels.data() + frame * FRAME_PIXELS;
+        for (size_t i = 0; i < FRAME_PIXELS; ++i)
+        {
+            const float expected =
+                i < counts[frame] ? check_value(frame, i) : clear;
+            if (row[i] != expected && wrong++ < 5)
+                std::cerr << "frame " << frame << " instance " << i
+                          << ": got " << row[i] << ", expected " << expected
+                          << std::endl;
+        }
+    }
+
+    std::cout << "Ring check: " << CHECK_FRAMES << " frames, ring of "
+              << ring.capacity() << " instances per frame, " << ring.stalls()
+              << " stalls, " << wrong << " wrong instances" << std::endl;
+
+    ring.destroy();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &target);
+    return wrong == 0;
+}
+
+// ########## THROUGHPUT ##########
+
+// Draws only fetch the instances: the rasterizer discards the points, so
+// the time measured is the upload and what it makes the driver wait for
+static void bench(GLuint program, GLuint vao, size_t instances, int frames)
+{
+    glUseProgram(program);
+    glBindVertexArray(vao);
+    glEnable(GL_RASTERIZER_DISCARD);
+    const GLint first_location = glGetUniformLocation(program, "uFirst");
+    const size_t background = instances / 8;
+
+    // ---------- staging vector + glBufferSubData into one buffer ----------
+
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, instances * STRIDE, nullptr,
+                 GL_DYNAMIC_DRAW);
+    std::vector<float> staging(instances * INSTANCE_FLOATS);
+
+    glFinish();
+    auto start = bench_clock::now();
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        // Both layers share the buffer from offset 0, like the old renderer
+        for (const size_t count : {background, instances - background})
+        {
+            fill(staging.data(), frame, 0, count);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, count * STRIDE,
+                            staging.data());
+            draw_points(buffer, 0, count, 0, first_location);
+        }
+    }
+    glFinish();
+    const double sub_data_ms = elapsed_ms(start);
+    glDeleteBuffers(1, &buffer);
+
+    // ---------- persistently mapped ring ----------
+
+    InstanceRing ring;
+    if (!ring.create(STRIDE, instances, instances))
+        return;
+
+    glFinish();
+    start = bench_clock::now();
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        ring.beginFrame();
+        for (const size_t count : {background, instances - background})
+        {
+            const InstanceRing::Span span = ring.allocate(count);
+            fill(static_cast<float *>(span.data), frame, 0, span.count);
+            draw_points(ring.buffer(), span.offset, span.count, 0,
+                        first_location);
+        }
+        ring.endFrame();
+    }
+    glFinish();
+    const double ring_ms = elapsed_ms(start);
+
+    std::cout << "Upload of " << instances << " instances x " << frames
+              << " frames:\n"
+              << "  glBufferSubData: " << sub_data_ms / frames
+              << " ms/frame\n"
+              << "  mapped ring:     " << ring_ms / frames << " ms/frame ("
+              << ring.stalls() << " stalls, " << ring.stallSeconds() * 1000.0
+              << " ms waiting)" << std::endl;
+
+    ring.destroy();
+    glDisable(GL_RASTERIZER_DISCARD);
+}
+
+int main(int argc, char **argv)
+{
+    const size_t instances =
+        argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 500000;
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 60;
+
+    if (!create_context())
+        return 1;
+
+    const GLuint program = point_program();
+    const GLuint vao = point_vao();
+
+    const bool ok = check_ring(program, vao);
+    if (instances > 0 && frames > 0)
+        bench(program, vao, instances, frames);
+
+    glDeleteVertexArrays(1, &vao);
+    glDeleteProgram(program);
+    return ok ? 0 : 1;
+}
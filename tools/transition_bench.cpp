@@ -0,0 +1,143 @@
+// Benchmark: cost of one frame in which many particles change state
+//
+// Usage: transition_bench [transitions] [population] [--legacy]
+//
+// Builds a settled pile, then times a single frame where `transitions`
+// particles are woken by the mouse (settled -> active) and the same number
+// land again (active -> settled) using the O(1) transitions of
+// obj::ParticleStore: swap-and-pop on the active list, archive records for
+// the settled pile. With --legacy the old migration (push_back +
+// std::remove per particle) is timed too; it is O(n*k) and takes minutes
+// at the default sizes in a Debug build.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "entities/particles.h"
+
+using bench_clock = std::chrono::steady_clock;
+
+static double elapsed_ms(bench_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(bench_clock::now() -
+                                                     start)
+        .count();
+}
+
+// Pick `count` distinct entries from `source` in random order
+static std::vector<u32> pick(const std::vector<u32> &source, size_t count,
+                             std::mt19937 &rng)
+{
+    std::vector<u32> picked = source;
+    std::shuffle(picked.begin(), picked.end(), rng);
+    picked.resize(std::min(count, picked.size()));
+    return picked;
+}
+
+// ---------- legacy: std::remove + erase per migrated particle ----------
+
+static double legacy_frame(std::vector<u32> active, std::vector<u32> settled,
+                           const std::vector<u32> &to_add,
+                           const std::vector<u32> &to_remove)
+{
+    auto start = bench_clock::now();
+
+    for (u32 r : to_add)
+        active.push_back(r);
+    for (u32 r : to_add)
+    {
+        auto it = std::remove(settled.begin(), settled.end(), r);
+        if (it != settled.end())
+            settled.erase(it, settled.end());
+    }
+
+    for (u32 r : to_remove)
+        settled.push_back(r);
+    for (u32 r : to_remove)
+    {
+        auto it = std::remove(active.begin(), active.end(), r);
+        if (it != active.end())
+            active.erase(it, active.end());
+    }
+
+    return elapsed_ms(start);
+}
+
+// ---------- current: O(1) swap-and-pop transitions ----------
+
+static double store_frame(obj::ParticleStore &store,
+                          const std::vector<u32> &to_add,
+                          const std::vector<u32> &to_remove)
+{
+    auto start = bench_clock::now();
+
+    for (u32 r : to_add)
+        store.wake(r, 0.0f);
+    for (u32 r : to_remove)
+        store.settle(r, 0.0f);
+
+    return elapsed_ms(start);
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<size_t> sizes;
+    bool run_legacy = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--legacy")
+            run_legacy = true;
+        else
+            sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+    }
+
+    const size_t transitions = sizes.size() > 0 ? sizes[0] : 50000;
+    const size_t population =
+        sizes.size() > 1 ? sizes[1] : 4 * transitions;
+
+    std::mt19937 rng(12345);
+
+    // Half the population is settled, half is airborne
+    obj::ParticleStore store;
+    store.reserve(population);
+    for (size_t i = 0; i < population; ++i)
+    {
+        u32 index = store.add(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+                              0.0f, 0);
+        if (i % 2 == 0)
+            store.settle(index, 0.0f);
+    }
+
+    std::vector<u32> settled;
+    store.settled.forEach([&settled](u32 id, const obj::SettledRecord &)
+                          { settled.push_back(id); });
+
+    // Wake some settled pieces and land some airborne ones in one frame
+    const std::vector<u32> to_add = pick(settled, transitions, rng);
+    const std::vector<u32> to_remove = pick(store.active, transitions, rng);
+
+    std::cout << "Population:  " << population << " particles ("
+              << store.active.size() << " active, " << store.settled.size()
+              << " settled)" << std::endl;
+    std::cout << "Transitions: " << to_add.size() << " woken + "
+              << to_remove.size() << " landed in one frame" << std::endl;
+
+    if (run_legacy)
+    {
+        double legacy_ms =
+            legacy_frame(store.active, settled, to_add, to_remove);
+        std::cout << "Legacy std::remove migration: " << legacy_ms << " ms"
+                  << std::endl;
+    }
+
+    double store_ms = store_frame(store, to_add, to_remove);
+    std::cout << "Swap-and-pop transitions:     " << store_ms << " ms"
+              << std::endl;
+
+    return 0;
+}